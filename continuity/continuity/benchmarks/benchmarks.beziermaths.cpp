@@ -0,0 +1,676 @@
+module;
+
+#include "simplemath/simplemath.h"
+
+module benchmarks;
+
+import stdxcore;
+import stdx;
+import vec;
+import random;
+import jobs;
+import beziermaths;
+import std;
+
+namespace benchmarks
+{
+
+using vector3 = DirectX::SimpleMath::Vector3;
+
+template<uint n, uint d>
+beziermaths::planarbezier<n, d> randombezier(stdx::xoshiro256& rng)
+{
+    beziermaths::planarbezier<n, d> b;
+    for (auto& c : b.controlnet)
+        c = vector3(rng.uniformf(-1.f, 1.f), rng.uniformf(-1.f, 1.f), rng.uniformf(-1.f, 1.f));
+    return b;
+}
+
+// largest distance between matching positions and unit derivatives of two tessellations
+template<typename eval_t>
+float maxerror(std::vector<eval_t> const& l, std::vector<eval_t> const& r)
+{
+    if (l.size() != r.size())
+        return std::numeric_limits<float>::max();
+
+    float err = 0.f;
+    for (uint i(0); i < l.size(); ++i)
+        for (uint k(0); k < l[i].size(); ++k)
+            err = std::max(err, (l[i][k] - r[i][k]).Length());
+    return err;
+}
+
+// triindex::to3d as it was before the tables, the row is recovered with a float sqrt and a tolerance offset
+template<uint n>
+stdx::triindex<n> sqrtto3d(uint idx1d)
+{
+    float const temp = (std::sqrt((static_cast<float>(idx1d) + 1.f) * 8.f + 1.f) - 1.f) / 2.0f - stdx::tolerance<>;
+    uint const row = static_cast<uint>(std::ceil(temp)) - 1u;
+    uint const j = n - row, k = idx1d - row * (row + 1) / 2;
+    return { n - j - k, j, k };
+}
+
+// decasteljau::triangle as it was before it walked triindex::all(), every sub net index is converted with sqrtto3d
+template<uint n>
+vector3 sqrtdecasteljau(beziermaths::beziertriangle<n> const& patch, vector3 const& uvw)
+{
+    if constexpr (n == 0)
+    {
+        return patch[0];
+    }
+    else
+    {
+        beziermaths::beziertriangle<n - 1> sub;
+        for (uint i(0); i < sub.numcontrolpts; ++i)
+        {
+            auto const idx = sqrtto3d<n - 1>(i);
+            sub[i] = patch[stdx::triindex<n>::to1d(idx.j, idx.k)] * uvw.x + patch[stdx::triindex<n>::to1d(idx.j + 1, idx.k)] * uvw.y + patch[stdx::triindex<n>::to1d(idx.j, idx.k + 1)] * uvw.z;
+        }
+
+        return sqrtdecasteljau<n - 1>(sub, uvw);
+    }
+}
+
+template<uint n>
+void triangle(report& r, stdx::xoshiro256& rng)
+{
+    beziermaths::beziertriangle<n> patch;
+    for (auto& c : patch.controlnet)
+        c = vector3(rng.uniformf(-1.f, 1.f), rng.uniformf(-1.f, 1.f), rng.uniformf(-1.f, 1.f));
+
+    constexpr uint count = 100000;
+    std::vector<vector3> params(count);
+    for (auto& p : params)
+    {
+        float u = rng.uniformf(), v = rng.uniformf();
+        if (u + v > 1.f)
+        {
+            u = 1.f - u;
+            v = 1.f - v;
+        }
+
+        p = vector3(1.f - u - v, u, v);
+    }
+
+    bool sameindices = true;
+    for (uint i(0); i < stdx::triindex<n>::count; ++i)
+    {
+        auto const table = stdx::triindex<n>::to3d(i), sqrt = sqrtto3d<n>(i);
+        sameindices = sameindices && table.i == sqrt.i && table.j == sqrt.j && table.k == sqrt.k;
+    }
+
+    float err = 0.f;
+    for (uint i(0); i < 1000; ++i)
+        err = std::max(err, (beziermaths::decasteljau<n, 0>::triangle(patch, params[i])[0] - sqrtdecasteljau<n>(patch, params[i])).Length());
+
+    vector3 sum;
+    double const tablems = r.time([&]() { sum = vector3(); for (auto const& p : params) sum += beziermaths::decasteljau<n, 0>::triangle(patch, p)[0]; }, 3);
+    r.keep(sum.x);
+    double const sqrtms = r.time([&]() { sum = vector3(); for (auto const& p : params) sum += sqrtdecasteljau<n>(patch, p); }, 3);
+    r.keep(sum.x);
+
+    std::string const degree = "beziertriangle<" + std::to_string(n) + ">";
+    r.value(degree + " with triindex tables", count / (tablems * 1e3), "Mevals/s");
+    r.value(degree + " with sqrt to3d", count / (sqrtms * 1e3), "Mevals/s");
+    r.check(sameindices, degree + " to3d tables match the sqrt conversion");
+    r.check(err < 1e-6f, degree + " evaluations match the sqrt conversion within 1e-6");
+}
+
+// de casteljau on triangular patches of degree 3 to 8, the sub nets are indexed in 1d order
+void triangle(report& r)
+{
+    stdx::xoshiro256 rng;
+    triangle<3>(r, rng);
+    triangle<4>(r, rng);
+    triangle<5>(r, rng);
+    triangle<6>(r, rng);
+    triangle<7>(r, rng);
+    triangle<8>(r, rng);
+}
+
+// reduces with computesubcontrolpoint one level at a time, the way evaluation worked before the cell tables
+template<uint n, uint d>
+beziermaths::planarbezier<n, 1> recursivedecasteljau(beziermaths::planarbezier<n, d> const& b, stdx::vec<n> const& p)
+{
+    if constexpr (d == 1)
+    {
+        return b;
+    }
+    else
+    {
+        beziermaths::planarbezier<n, d - 1> sub;
+        uint i = 0;
+        for (auto const& idx : stdx::grididx<n - 1>::range(d - 1))
+            sub[i++] = beziermaths::planarbezier<n, d>::computesubcontrolpoint(idx, b, p);
+        return recursivedecasteljau<n, d - 1>(sub, p);
+    }
+}
+
+template<uint n, uint d>
+void decasteljau(report& r, stdx::xoshiro256& rng)
+{
+    using bezier_t = beziermaths::planarbezier<n, d>;
+    auto const b = randombezier<n, d>(rng);
+
+    constexpr uint count = 100000;
+    std::vector<stdx::vec<n>> params(count);
+    for (auto& p : params)
+        for (uint k(0); k < n; ++k)
+            p[k] = rng.uniformf();
+
+    float err = 0.f;
+    for (uint i(0); i < 1000; ++i)
+    {
+        auto const tables = bezier_t::template decasteljau<1>(b, params[i]);
+        auto const recursion = recursivedecasteljau<n, d>(b, params[i]);
+        for (uint k(0); k < tables.numcontrolpts; ++k)
+            err = std::max(err, (tables[k] - recursion[k]).Length());
+    }
+
+    vector3 sum;
+    double const tablesms = r.time([&]() { sum = vector3(); for (auto const& p : params) sum += bezier_t::template decasteljau<1>(b, p)[0]; }, 3);
+    r.keep(sum.x);
+    double const recursionms = r.time([&]() { sum = vector3(); for (auto const& p : params) sum += recursivedecasteljau<n, d>(b, p)[0]; }, 3);
+    r.keep(sum.x);
+
+    std::string const shape = "<" + std::to_string(n) + ", " + std::to_string(d) + ">";
+    r.value("cell tables " + shape, tablesms * 1e6 / count, "ns");
+    r.value("recursion " + shape, recursionms * 1e6 / count, "ns");
+    r.check(err < 1e-5f, "cell tables match the recursion within 1e-5 for " + shape);
+}
+
+// reductions of planarbezier<n, d> to its linear cell
+void decasteljau(report& r)
+{
+    stdx::xoshiro256 rng;
+    decasteljau<1, 2>(r, rng);
+    decasteljau<1, 3>(r, rng);
+    decasteljau<2, 2>(r, rng);
+    decasteljau<2, 3>(r, rng);
+    decasteljau<3, 2>(r, rng);
+    decasteljau<3, 3>(r, rng);
+}
+
+template<uint n, uint d>
+void soa(report& r, stdx::xoshiro256& rng)
+{
+    using bezier_t = beziermaths::planarbezier<n, d>;
+    auto const b = randombezier<n, d>(rng);
+
+    constexpr uint count = 1 << 18;
+    std::vector<typename bezier_t::param_t> params(count);
+    std::array<std::vector<float>, n> paramsoa;
+    for (auto& p : params)
+        for (uint k(0); k < n; ++k)
+            p[k] = rng.uniformf();
+    for (uint k(0); k < n; ++k)
+        for (auto const& p : params)
+            paramsoa[k].push_back(p[k]);
+
+    std::array<std::vector<float>, 3> position;
+    std::array<std::array<std::vector<float>, 3>, n> tangents;
+    typename bezier_t::paramsoa_t soaparams;
+    typename bezier_t::evalsoa_t withtangents, positionsonly;
+    for (uint k(0); k < n; ++k)
+        soaparams[k] = paramsoa[k];
+    for (uint k(0); k < 3; ++k)
+    {
+        position[k].resize(count);
+        withtangents.position[k] = positionsonly.position[k] = position[k];
+        for (uint i(0); i < n; ++i)
+        {
+            tangents[i][k].resize(count);
+            withtangents.tangents[i][k] = tangents[i][k];
+        }
+    }
+
+    vector3 sum;
+    double const scalarms = r.time([&]() { sum = vector3(); for (auto const& p : params) sum += b.eval(p)[1]; }, 3);
+    r.keep(sum.x);
+    double const soams = r.time([&]() { b.eval(soaparams, withtangents); }, 3);
+    r.keep(tangents[0][0][count / 2]);
+    double const positionms = r.time([&]() { b.eval(soaparams, positionsonly); }, 3);
+    r.keep(position[0][count / 2]);
+
+    // the last run wrote positions only, run once more to compare tangents as well
+    b.eval(soaparams, withtangents);
+    float err = 0.f;
+    for (uint j(0); j < count; j += 7)
+    {
+        auto const e = b.eval(params[j]);
+        err = std::max(err, (vector3(position[0][j], position[1][j], position[2][j]) - e[0]).Length());
+        for (uint i(0); i < n; ++i)
+            err = std::max(err, (vector3(tangents[i][0][j], tangents[i][1][j], tangents[i][2][j]) - e[i + 1]).Length());
+    }
+
+    std::string const shape = "<" + std::to_string(n) + ", " + std::to_string(d) + ">";
+    r.value("scalar eval " + shape, count / (scalarms * 1e3), "Mevals/s");
+    r.value("soa eval " + shape, count / (soams * 1e3), "Mevals/s");
+    r.value("soa eval without tangents " + shape, count / (positionms * 1e3), "Mevals/s");
+    r.check(err < 1e-5f, "soa eval " + shape + " matches the scalar eval within 1e-5");
+}
+
+// planarbezier::eval one parameter at a time against stdx::simd::f32pack::width parameters per step
+void soa(report& r)
+{
+    stdx::xoshiro256 rng;
+    r.note("f32pack width " + std::to_string(stdx::simd::f32pack::width));
+    soa<2, 3>(r, rng);
+    soa<3, 2>(r, rng);
+}
+
+template<uint n>
+void volume(report& r, stdx::xoshiro256& rng)
+{
+    beziermaths::beziervolume<n> vol;
+    for (auto& c : vol.controlnet)
+        c = vector3(rng.uniformf(-1.f, 1.f), rng.uniformf(-1.f, 1.f), rng.uniformf(-1.f, 1.f));
+
+    constexpr uint count = 100000;
+    std::vector<vector3> params(count);
+    for (auto& p : params)
+        p = vector3(rng.uniformf(), rng.uniformf(), rng.uniformf());
+
+    // positions against de casteljau, partials against central differences of it
+    float poserr = 0.f, partialerr = 0.f;
+    constexpr float h = 1e-3f;
+    for (uint i(0); i < 1000; ++i)
+    {
+        auto const& p = params[i];
+        auto const e = beziermaths::evaluatepartials(vol, p);
+        poserr = std::max(poserr, (e[0] - beziermaths::evaluate(vol, p)).Length());
+        for (uint a(0); a < 3; ++a)
+        {
+            vector3 lo = p, hi = p;
+            (&lo.x)[a] -= h;
+            (&hi.x)[a] += h;
+            partialerr = std::max(partialerr, (e[a + 1] - (beziermaths::evaluate(vol, hi) - beziermaths::evaluate(vol, lo)) / (2.f * h)).Length());
+        }
+    }
+
+    vector3 sum;
+    double const scalarms = r.time([&]() { sum = vector3(); for (auto const& p : params) sum += beziermaths::evaluate(vol, p); }, 3);
+    r.keep(sum.x);
+    double const partialsms = r.time([&]() { sum = vector3(); for (auto const& p : params) sum += beziermaths::evaluatepartials(vol, p)[0]; }, 3);
+    r.keep(sum.x);
+    float frame = 0.f;
+    double const fastms = r.time([&]() { frame = 0.f; for (auto const& p : params) frame += beziermaths::evaluatefast(vol, p).second[0][0]; }, 3);
+    r.keep(frame);
+
+    std::string const degree = "beziervolume<" + std::to_string(n) + ">";
+    r.value(degree + " de casteljau position", scalarms * 1e6 / count, "ns");
+    r.value(degree + " evaluatepartials position and partials", partialsms * 1e6 / count, "ns");
+    r.value(degree + " evaluatefast position and frame", fastms * 1e6 / count, "ns");
+    r.check(poserr < 1e-5f, degree + " evaluatepartials matches de casteljau within 1e-5");
+    r.check(partialerr < 1e-2f, degree + " partials match central differences within 1e-2");
+}
+
+// the degree generic volume evaluator at the degrees the samples and ffd use
+void volume(report& r)
+{
+    stdx::xoshiro256 rng;
+    volume<2>(r, rng);
+    volume<3>(r, rng);
+    volume<4>(r, rng);
+}
+
+// bulkevaluate with 1 up to every thread, capped with limitthreads
+void bulkevaluate(report& r)
+{
+    stdx::xoshiro256 rng;
+    beziermaths::beziervolume<2> vol;
+    for (auto& c : vol.controlnet)
+        c = vector3(rng.uniformf(-1.f, 1.f), rng.uniformf(-1.f, 1.f), rng.uniformf(-1.f, 1.f));
+
+    constexpr uint count = 1 << 20;
+    std::vector<beziermaths::vertex> vertices(count), deformed(count), reference;
+    for (auto& v : vertices)
+        v = { vector3(rng.uniformf(), rng.uniformf(), rng.uniformf()), vector3(rng.uniformf(-1.f, 1.f), rng.uniformf(-1.f, 1.f), rng.uniformf(-1.f, 1.f)).Normalized() };
+
+    auto& system = stdx::jobsystem::get();
+    uint const numthreads = system.numthreads();
+
+    double single = 0.;
+    bool same = true;
+    for (uint threads(1); threads <= numthreads; ++threads)
+    {
+        system.limitthreads(threads);
+        double const ms = r.time([&]() { beziermaths::bulkevaluate(vol, std::span<beziermaths::vertex const>(vertices), std::span<beziermaths::vertex>(deformed)); }, 3);
+        if (threads == 1)
+        {
+            single = ms;
+            reference = deformed;
+        }
+
+        // every vertex is evaluated on its own, so the split across threads can't change the results
+        same = same && deformed == reference;
+
+        std::string const suffix = " (1M vertices, " + std::to_string(threads) + (threads == 1 ? " thread)" : " threads)");
+        r.value("bulkevaluate" + suffix, count / (ms * 1e3), "Mvertices/s");
+        r.value("bulkevaluate speedup" + suffix, single / ms, "x");
+    }
+
+    system.limitthreads(0);
+    r.keep(deformed[count / 2].first.x);
+
+    r.check(same, "bulkevaluate gives the same vertices at every thread count");
+}
+
+template<uint n, uint d>
+void baked(report& r, stdx::xoshiro256& rng)
+{
+    using bezier_t = beziermaths::planarbezier<n, d>;
+    auto const b = randombezier<n, d>(rng);
+    beziermaths::bakedbezier<n, d> const baked(b);
+
+    constexpr uint count = 1 << 16;
+    std::vector<typename bezier_t::param_t> params(count);
+    std::array<std::vector<float>, n> paramsoa;
+    for (auto& p : params)
+        for (uint k(0); k < n; ++k)
+            p[k] = rng.uniformf();
+    for (uint k(0); k < n; ++k)
+        for (auto const& p : params)
+            paramsoa[k].push_back(p[k]);
+
+    // precision of horner in the power basis against de casteljau on the same net
+    float poserr = 0.f, tangenterr = 0.f;
+    for (auto const& p : params)
+    {
+        auto const exact = b.eval(p);
+        auto const e = baked.eval(p);
+        poserr = std::max(poserr, (exact[0] - e[0]).Length());
+        for (uint i(1); i <= n; ++i)
+            tangenterr = std::max(tangenterr, (exact[i] - e[i]).Length());
+    }
+
+    std::string const shape = "<" + std::to_string(n) + ", " + std::to_string(d) + ">";
+    r.value("baked position error " + shape, poserr, "");
+    r.value("baked tangent error " + shape, tangenterr, "");
+    r.check(poserr < 2e-6f && tangenterr < 5e-5f, "baked " + shape + " is within 2e-6 in position and 5e-5 in unit tangents of de casteljau");
+
+    vector3 sum;
+    double const decasteljaums = r.time([&]() { sum = vector3(); for (auto const& p : params) sum += b.eval(p)[1]; }, 3);
+    r.keep(sum.x);
+    double const bakedms = r.time([&]() { sum = vector3(); for (auto const& p : params) sum += baked.eval(p)[1]; }, 3);
+    r.keep(sum.x);
+    r.value("de casteljau eval " + shape, decasteljaums * 1e6 / count, "ns");
+    r.value("baked eval " + shape, bakedms * 1e6 / count, "ns");
+
+    // the same through the structure of arrays evals
+    std::array<std::vector<float>, 3> position;
+    std::array<std::array<std::vector<float>, 3>, n> tangents;
+    typename bezier_t::paramsoa_t soaparams;
+    typename bezier_t::evalsoa_t soa;
+    for (uint k(0); k < n; ++k)
+        soaparams[k] = paramsoa[k];
+    for (uint k(0); k < 3; ++k)
+    {
+        position[k].resize(count);
+        soa.position[k] = position[k];
+        for (uint i(0); i < n; ++i)
+        {
+            tangents[i][k].resize(count);
+            soa.tangents[i][k] = tangents[i][k];
+        }
+    }
+
+    double const decasteljausoams = r.time([&]() { b.eval(soaparams, soa); }, 3);
+    r.keep(position[0][count / 2]);
+    double const bakedsoams = r.time([&]() { baked.eval(soaparams, soa); }, 3);
+    r.keep(position[0][count / 2]);
+    r.value("de casteljau soa eval " + shape, decasteljausoams * 1e6 / count, "ns");
+    r.value("baked soa eval " + shape, bakedsoams * 1e6 / count, "ns");
+
+    float soaerr = 0.f;
+    for (uint j(0); j < count; ++j)
+        soaerr = std::max(soaerr, (vector3(position[0][j], position[1][j], position[2][j]) - baked.eval(params[j])[0]).Length());
+    r.check(soaerr < 1e-6f, "baked soa eval " + shape + " matches the scalar one");
+}
+
+// power basis evaluation for degrees 1 to 6, curves and patches, and low degree volumes
+void baked(report& r)
+{
+    stdx::xoshiro256 rng;
+    [&]<uint... d>(std::integer_sequence<uint, d...>)
+    {
+        (baked<1, d + 1>(r, rng), ...);
+        (baked<2, d + 1>(r, rng), ...);
+    }(std::make_integer_sequence<uint, 6>{});
+
+    baked<3, 2>(r, rng);
+    baked<3, 3>(r, rng);
+}
+
+// forward differenced tessellation against exact evaluation of every sample
+void forwarddiff(report& r)
+{
+    stdx::xoshiro256 rng;
+    auto const curve = randombezier<1, 3>(rng);
+    auto const curve5 = randombezier<1, 5>(rng);
+    auto const patch = randombezier<2, 3>(rng);
+
+    // control points are in [-1, 1]^3, so the tolerance is relative to a unit sized shape
+    constexpr float tolerance = 1e-4f;
+    for (uint intervals : { 64u, 256u, 1024u, 4096u })
+    {
+        std::string const samples = std::to_string(intervals + 1) + " samples";
+        std::vector<beziermaths::planarbezier<1, 3>::eval_t> exact, forward;
+        double const exactms = r.time([&]() { exact.clear(); beziermaths::tessellate(curve, intervals, exact); });
+        double const forwardms = r.time([&]() { forward.clear(); beziermaths::tessellateforward(curve, intervals, forward); });
+        r.value("cubic curve exact, " + samples, exactms, "ms");
+        r.value("cubic curve forward, " + samples, forwardms, "ms");
+        r.check(maxerror(exact, forward) < tolerance, "cubic curve forward matches exact within 1e-4, " + samples);
+        r.check(maxerror(beziermaths::tessellate(curve5, intervals), beziermaths::tessellateforward(curve5, intervals)) < tolerance, "quintic curve forward matches exact within 1e-4, " + samples);
+    }
+
+    for (uint intervals : { 64u, 256u })
+    {
+        std::string const samples = std::to_string(intervals + 1) + "^2 samples";
+        std::vector<beziermaths::planarbezier<2, 3>::eval_t> exact, forward;
+        double const exactms = r.time([&]() { exact.clear(); beziermaths::tessellate(patch, intervals, exact); }, 3);
+        double const forwardms = r.time([&]() { forward.clear(); beziermaths::tessellateforward(patch, intervals, forward); }, 3);
+        r.value("bicubic patch exact, " + samples, exactms, "ms");
+        r.value("bicubic patch forward, " + samples, forwardms, "ms");
+        r.check(maxerror(exact, forward) < tolerance, "bicubic patch forward matches exact within 1e-4, " + samples);
+    }
+
+    // without re-anchoring the error grows with the number of steps
+    r.value("cubic curve error anchored every 64 steps, 4097 samples", maxerror(beziermaths::tessellate(curve, 4096), beziermaths::tessellateforward(curve, 4096)), "");
+    r.value("cubic curve error never re-anchored, 4097 samples", maxerror(beziermaths::tessellate(curve, 4096), beziermaths::tessellateforward(curve, 4096, 0)), "");
+    r.check(maxerror(beziermaths::tessellate(curve, 64), beziermaths::tessellateforward(curve, 64, 0)) < tolerance, "anchorinterval 0 anchors once and stays within 1e-4 for 65 samples");
+}
+
+// undirected edges of a mesh with the number of triangles using each
+std::map<std::pair<uint32, uint32>, uint> edgeuses(std::vector<uint32> const& indices)
+{
+    std::map<std::pair<uint32, uint32>, uint> r;
+    for (uint t(0); t < indices.size(); t += 3)
+        for (uint i(0); i < 3; ++i)
+            ++r[std::minmax(indices[t + i], indices[t + (i + 1) % 3])];
+    return r;
+}
+
+// a 2x2 set of bicubic patches cut from one c0 height field, so every shared edge splits differently on its two sides
+// the last patch is mirrored in u, its shared edge runs the other way
+void adaptive(report& r)
+{
+    constexpr uint d = 3;
+    constexpr uint side = 2 * d + 1;
+    stdx::xoshiro256 rng;
+    std::array<float, side * side> heights;
+    for (uint j(0); j < side; ++j)
+        for (uint i(0); i < side; ++i)
+            heights[j * side + i] = (i < d + 1 && j < d + 1 ? 0.05f : 0.6f) * rng.uniformf(-1.f, 1.f);
+
+    std::vector<beziermaths::planarbezier<2, d>> patches(4);
+    for (uint p(0); p < 4; ++p)
+    {
+        uint const pi = p % 2, pj = p / 2;
+        for (uint l(0); l <= d; ++l)
+        {
+            for (uint k(0); k <= d; ++k)
+            {
+                uint const i = pi * d + (p == 3 ? d - k : k), j = pj * d + l;
+                patches[p][l * (d + 1) + k] = vector3(float(i) / d, float(j) / d, heights[j * side + i]);
+            }
+        }
+    }
+
+    auto const adjacency = beziermaths::edgeadjacency(std::span<beziermaths::planarbezier<2, d> const>(patches));
+    uint numshared = 0, numreversed = 0;
+    for (auto const& a : adjacency)
+    {
+        for (auto const& n : a)
+        {
+            numshared += n.patch != stdx::invalid<uint32> ? 1 : 0;
+            numreversed += n.patch != stdx::invalid<uint32> && n.reversed ? 1 : 0;
+        }
+    }
+
+    r.check(numshared == 8 && numreversed == 2, "edgeadjacency finds the 4 shared edges, 1 of them reversed");
+
+    for (float tolerance : { 0.01f, 0.001f })
+    {
+        std::string const tol = "tolerance " + std::to_string(tolerance).substr(0, 5);
+        beziermaths::trimesh<beziermaths::patchuv> set;
+        double const setms = r.time([&]() { set = beziermaths::tessellateadaptive(std::span<beziermaths::planarbezier<2, d> const>(patches), std::span<beziermaths::patchadjacency const>(adjacency), tolerance); }, 3);
+        r.value("patch set " + tol, setms, "ms");
+        r.value("patch set triangles, " + tol, double(set.indices.size() / 3), "");
+
+        // edges used once have to lie on the border of the set, anything else is a crack or a t junction
+        uint open = 0;
+        for (auto const& [e, uses] : edgeuses(set.indices))
+        {
+            auto const& a = set.positions[e.first];
+            auto const& b = set.positions[e.second];
+            auto const at = [](float x, float y) { return std::abs(x - y) < 1e-5f; };
+            bool const border = (at(a.x, 0.f) && at(b.x, 0.f)) || (at(a.x, 2.f) && at(b.x, 2.f)) || (at(a.y, 0.f) && at(b.y, 0.f)) || (at(a.y, 2.f) && at(b.y, 2.f));
+            open += uses > 2 || (uses == 1 && !border) ? 1 : 0;
+        }
+
+        r.check(open == 0, "patch set mesh has no open interior edges, " + tol);
+
+        // the same patches one at a time, a vertex on a shared edge that the other side lacks is a t junction
+        std::vector<beziermaths::trimesh<stdx::vec2>> singles;
+        for (auto const& patch : patches)
+            singles.push_back(beziermaths::tessellateadaptive(patch, tolerance));
+
+        auto const edgepoints = [](beziermaths::trimesh<stdx::vec2> const& m, uint32 edge, bool reversed)
+        {
+            std::set<int> r;
+            for (auto const& uv : m.params)
+            {
+                float const across = edge == 0 || edge == 2 ? uv[1] : uv[0];
+                float const along = edge == 0 || edge == 2 ? uv[0] : uv[1];
+                if (across == (edge == 1 || edge == 2 ? 1.f : 0.f))
+                    r.insert(int(std::lround((reversed ? 1.f - along : along) * 1024.f)));
+            }
+
+            return r;
+        };
+
+        uint tjunctions = 0;
+        for (uint32 p(0); p < patches.size(); ++p)
+        {
+            for (uint32 e(0); e < 4; ++e)
+            {
+                if (auto const& n = adjacency[p][e]; n.patch != stdx::invalid<uint32>)
+                {
+                    auto const mine = edgepoints(singles[p], e, false);
+                    auto const theirs = edgepoints(singles[n.patch], n.edge, n.reversed);
+                    tjunctions += uint(std::ranges::count_if(mine, [&theirs](int t) { return !theirs.contains(t); }));
+                }
+            }
+        }
+
+        r.value("t junctions when the patches are tessellated one at a time, " + tol, double(tjunctions), "");
+    }
+}
+
+
+// closest points on random curves, one query at a time in scalar code and in batches, both checked against dense sampling
+template<uint d>
+void closestpoint(report& r, stdx::xoshiro256& rng)
+{
+    constexpr uint numcurves = 64, percurve = 256;
+    std::vector<beziermaths::planarbezier<1, d>> curves(numcurves);
+    for (auto& c : curves)
+        c = randombezier<1, d>(rng);
+
+    // queries for curve c are points[c * percurve, (c + 1) * percurve)
+    std::vector<vector3> points(numcurves * percurve);
+    for (auto& p : points)
+        p = vector3(rng.uniformf(-1.5f, 1.5f), rng.uniformf(-1.5f, 1.5f), rng.uniformf(-1.5f, 1.5f));
+
+    std::vector<beziermaths::curvepoint> batched(points.size());
+    std::vector<beziermaths::paramandpoint> scalar(points.size());
+
+    // what the single point overload used to do, a query set up for every point
+    double const setupms = r.time([&]()
+    {
+        for (uint i(0); i < points.size(); ++i)
+            batched[i] = beziermaths::closestpointquery<d>(std::span(&curves[i / percurve], 1)).query(std::span(&points[i], 1))[0];
+    });
+
+    r.keep(batched[points.size() / 2].t);
+
+    double const scalarms = r.time([&]()
+    {
+        for (uint i(0); i < points.size(); ++i)
+            scalar[i] = beziermaths::closestpoint(curves[i / percurve], points[i]);
+    });
+
+    r.keep(scalar[points.size() / 2].first);
+
+    std::vector<beziermaths::closestpointquery<d>> queries;
+    for (uint c(0); c < numcurves; ++c)
+        queries.emplace_back(std::span(&curves[c], 1));
+
+    // single threaded like the scalar loop, so the difference is only the simd lanes
+    double const batchms = r.time([&]()
+    {
+        for (uint c(0); c < numcurves; ++c)
+            queries[c].query(std::span(points).subspan(c * percurve, percurve), std::span(batched).subspan(c * percurve), percurve);
+    });
+
+    r.keep(batched[points.size() / 2].t);
+
+    std::string const degree = "degree " + std::to_string(d);
+    auto const mqueries = [&points](double ms) { return double(points.size()) / (ms * 1e3); };
+    r.value(degree + " query set up per point", mqueries(setupms), "Mqueries/s");
+    r.value(degree + " scalar closestpoint", mqueries(scalarms), "Mqueries/s");
+    r.value(degree + " closestpointquery batches of 256", mqueries(batchms), "Mqueries/s");
+
+    // neither can be further than the closest of 8193 samples, beyond what the sample spacing explains
+    constexpr uint numchecked = 64;
+    float scalarexcess = 0.f, batchedexcess = 0.f, mismatch = 0.f;
+    for (uint c(0); c < numcurves; ++c)
+    {
+        auto const samples = beziermaths::tessellate(curves[c], 8192);
+        for (uint i(c * percurve); i < c * percurve + numchecked; ++i)
+        {
+            float brute = std::numeric_limits<float>::max();
+            for (auto const& s : samples)
+                brute = std::min(brute, vector3::Distance(s[0], points[i]));
+
+            scalarexcess = std::max(scalarexcess, vector3::Distance(scalar[i].second, points[i]) - brute);
+            batchedexcess = std::max(batchedexcess, vector3::Distance(batched[i].position, points[i]) - brute);
+            mismatch = std::max(mismatch, (curves[c].eval(stdx::vec1{ scalar[i].first })[0] - scalar[i].second).Length());
+        }
+    }
+
+    r.value(degree + " scalar distance beyond dense sampling", scalarexcess, "");
+    r.value(degree + " batched distance beyond dense sampling", batchedexcess, "");
+    r.check(scalarexcess < 1e-4f && batchedexcess < 1e-4f, degree + " closest points are no further than the closest of 8193 samples");
+    r.check(mismatch < 1e-4f, degree + " scalar closestpoint positions lie on the curve at their parameter");
+}
+
+void closestpoint(report& r)
+{
+    stdx::xoshiro256 rng;
+    closestpoint<3>(r, rng);
+    closestpoint<5>(r, rng);
+}
+
+}
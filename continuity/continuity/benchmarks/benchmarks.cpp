@@ -0,0 +1,158 @@
+module;
+
+#include "thirdparty/rapidobj.hpp"
+
+module benchmarks;
+
+namespace benchmarks
+{
+
+void report::value(std::string_view what, double v, std::string_view unit)
+{
+    out << "  " << what << ": " << std::defaultfloat << std::setprecision(4) << v << ' ' << unit << '\n';
+}
+
+void report::note(std::string_view what)
+{
+    out << "  " << what << '\n';
+}
+
+void report::check(bool ok, std::string_view what)
+{
+    out << "  " << (ok ? "ok   " : "FAIL ") << what << '\n';
+    numfailures += ok ? 0 : 1;
+}
+
+std::vector<mesh> loadmeshes(report& r)
+{
+    std::vector<mesh> res;
+    for (std::string const path : { "models/cornellbox.obj", "models/spot.obj", "models/sponza/sponza.obj" })
+    {
+        if (!std::filesystem::exists(path))
+        {
+            r.note(path + " not found, skipped");
+            continue;
+        }
+
+        rapidobj::Result result = rapidobj::ParseFile(std::filesystem::path(path), rapidobj::MaterialLibrary::Default(rapidobj::Load::Optional));
+        if (!result.error)
+            rapidobj::Triangulate(result);
+
+        if (result.error)
+        {
+            r.note(path + " failed to load, skipped: " + result.error.code.message());
+            continue;
+        }
+
+        auto& m = res.emplace_back();
+        m.name = std::filesystem::path(path).stem().string();
+
+        auto const& positions = result.attributes.positions;
+        for (uint i(0); i < positions.size(); i += 3)
+            m.positions.push_back({ positions[i], positions[i + 1], positions[i + 2] });
+
+        auto const& normals = result.attributes.normals;
+        for (uint i(0); i < normals.size(); i += 3)
+            m.tbns.emplace_back().normal = stdx::vec3{ normals[i], normals[i + 1], normals[i + 2] };
+
+        auto const& texcoords = result.attributes.texcoords;
+        for (auto const& shape : result.shapes)
+        {
+            auto const& indices = shape.mesh.indices;
+            for (uint i(0); i < indices.size(); i += 3)
+            {
+                stdx::vec3 ps[3];
+                stdx::vec2 uvs[3] = {};
+                for (uint j(0); j < 3; ++j)
+                {
+                    // vertices without a normal get a tbn of their own, the face normals are summed into it
+                    auto const& idx = indices[i + j];
+                    uint32 const tbn = idx.normal_index != -1 ? uint32(idx.normal_index) : uint32(m.tbns.size());
+                    if (idx.normal_index == -1)
+                        m.tbns.emplace_back();
+
+                    m.indices.push_back({ uint32(idx.position_index), 0, tbn });
+                    ps[j] = m.positions[idx.position_index];
+                    if (idx.texcoord_index != -1)
+                        uvs[j] = { texcoords[idx.texcoord_index * 2], texcoords[idx.texcoord_index * 2 + 1] };
+                }
+
+                float const x0 = uvs[1][0] - uvs[0][0], x1 = uvs[2][0] - uvs[0][0];
+                float const y0 = uvs[1][1] - uvs[0][1], y1 = uvs[2][1] - uvs[0][1];
+                float const det = x0 * y1 - x1 * y0;
+                stdx::vec3 const e0 = ps[1] - ps[0], e1 = ps[2] - ps[0];
+
+                stdx::vec3 t{}, b{};
+                if (std::abs(det) > 1e-30f)
+                {
+                    t = (e0 * y1 - e1 * y0) / det;
+                    b = (e1 * x0 - e0 * x1) / det;
+                }
+
+                stdx::vec3 const n = e0.cross(e1).normalized();
+                for (uint j(0); j < 3; ++j)
+                {
+                    auto& frame = m.tbns[m.indices[m.indices.size() - 3 + j].tbn];
+                    if (indices[i + j].normal_index == -1)
+                        frame.normal += n;
+
+                    frame.tangent += t;
+                    frame.bitangent += b;
+                }
+            }
+        }
+    }
+
+    return res;
+}
+
+uint run(std::string_view filter, std::ostream& out)
+{
+    struct entry
+    {
+        std::string_view name;
+        void (*run)(report&);
+    };
+
+    static constexpr entry entries[] =
+    {
+        { "vec", vec },
+        { "tbn", tbn },
+        { "jobs", jobs },
+        { "join", join },
+        { "grid", grid },
+        { "random", random },
+        { "flathash", flathash },
+        { "triangle", triangle },
+        { "decasteljau", decasteljau },
+        { "soa", soa },
+        { "volume", volume },
+        { "bulkevaluate", bulkevaluate },
+        { "baked", baked },
+        { "forwarddiff", forwarddiff },
+        { "adaptive", adaptive },
+        { "closestpoint", closestpoint },
+        { "bvh", bvh },
+        { "bvh8", bvh8 },
+        { "lbvh", lbvh },
+        { "refit", refit },
+        { "aabbset", aabbset },
+        { "ffd", ffd },
+    };
+
+    report r(out);
+    for (auto const& e : entries)
+    {
+        if (e.name.find(filter) == std::string_view::npos)
+            continue;
+
+        out << e.name << '\n';
+        e.run(r);
+        out.flush();
+    }
+
+    out << r.failures() << " failed checks\n";
+    return r.failures();
+}
+
+}
@@ -0,0 +1,476 @@
+module benchmarks;
+
+import stdxcore;
+import stdx;
+import vec;
+import random;
+import jobs;
+import geometry;
+import graphicscore;
+import std;
+
+namespace benchmarks
+{
+
+// origins anywhere in the mesh's bounds grown by half on every side, directions uniform on the sphere
+std::vector<geometry::ray> randomrays(mesh const& m, uint count, stdx::xoshiro256& rng)
+{
+    geometry::aabb const bounds(m.positions);
+    auto const lo = bounds.min_pt - bounds.span() * 0.5f, hi = bounds.max_pt + bounds.span() * 0.5f;
+
+    std::vector<geometry::ray> res;
+    res.reserve(count);
+    for (uint i(0); i < count; ++i)
+    {
+        float const z = rng.uniformf(-1.f, 1.f), phi = rng.uniformf(0.f, 2.f * std::numbers::pi_v<float>);
+        float const s = std::sqrt(1.f - z * z);
+        res.emplace_back(stdx::vec3{ rng.uniformf(lo[0], hi[0]), rng.uniformf(lo[1], hi[1]), rng.uniformf(lo[2], hi[2]) }, stdx::vec3{ s * std::cos(phi), s * std::sin(phi), z });
+    }
+
+    return res;
+}
+
+// rays along the axes from outside the bounds, the other two components of their directions are negative zero
+std::vector<geometry::ray> axisrays(mesh const& m, uint count, stdx::xoshiro256& rng)
+{
+    geometry::aabb const bounds(m.positions);
+    auto const lo = bounds.min_pt, hi = bounds.max_pt;
+    std::vector<geometry::ray> res;
+    res.reserve(count);
+    for (uint i(0); i < count; ++i)
+    {
+        uint const a = i % 3, b = (a + 1) % 3, c = (a + 2) % 3;
+        bool const backwards = (i / 3) % 2 == 1;
+        stdx::vec3 origin, dir = { -0.f, -0.f, -0.f };
+        origin[a] = backwards ? hi[a] + 1.f : lo[a] - 1.f;
+        origin[b] = rng.uniformf(lo[b], hi[b]);
+        origin[c] = rng.uniformf(lo[c], hi[c]);
+        dir[a] = backwards ? -1.f : 1.f;
+        res.emplace_back(origin, dir);
+    }
+
+    return res;
+}
+
+// nearest hit over every triangle, the same intersection test trianglebvh uses
+std::optional<float> brutehit(mesh const& m, geometry::ray const& r)
+{
+    std::optional<float> res;
+    for (uint i(0); i < m.indices.size(); i += 3)
+    {
+        auto const& v0 = m.positions[m.indices[i].pos];
+        auto const e1 = m.positions[m.indices[i + 1].pos] - v0, e2 = m.positions[m.indices[i + 2].pos] - v0;
+        auto const p = r.dir.cross(e2);
+        float const det = e1.dot(p);
+        if (std::abs(det) < std::numeric_limits<float>::min())
+            continue;
+
+        float const invdet = 1.f / det;
+        auto const s = r.origin - v0;
+        float const u = s.dot(p) * invdet;
+        auto const q = s.cross(e1);
+        float const v = r.dir.dot(q) * invdet;
+        float const t = e2.dot(q) * invdet;
+        if (u >= 0.f && v >= 0.f && u + v <= 1.f && t >= r.tmin && t < res.value_or(r.tmax))
+            res = t;
+    }
+
+    return res;
+}
+
+// hits of the first rays against brute force, both have to agree on whether there is a hit and where it is
+template<typename hits_t>
+bool matchesbruteforce(mesh const& m, std::span<geometry::ray const> rays, hits_t const& hits, std::span<bool const> anyhits, uint count)
+{
+    bool ok = true;
+    for (uint i(0); i < std::min(count, rays.size()); ++i)
+    {
+        auto const expected = brutehit(m, rays[i]);
+        ok = ok && expected.has_value() == hits[i].has_value() && expected.has_value() == anyhits[i];
+        ok = ok && (!expected || std::abs(*expected - hits[i]->t) <= 1e-4f * std::max(1.f, *expected));
+    }
+
+    return ok;
+}
+
+// every primitive in exactly one leaf, every box inside its node's bounds and no deeper than traversal stacks allow
+bool validbvh(geometry::bvh const& tree, std::span<geometry::aabb const> boxes)
+{
+    auto const& nodes = tree.nodes();
+    auto const& prims = tree.primitives();
+    if (nodes.empty() || prims.size() != boxes.size())
+        return false;
+
+    auto const inside = [](geometry::aabb const& in, geometry::aabb const& out)
+    {
+        for (uint a(0); a < 3; ++a)
+            if (in.min_pt[a] < out.min_pt[a] || in.max_pt[a] > out.max_pt[a])
+                return false;
+        return true;
+    };
+
+    std::vector<uint8> seen(boxes.size());
+    std::vector<std::pair<uint32, uint>> stack = { { 0, 1 } };
+    while (!stack.empty())
+    {
+        auto const [idx, depth] = stack.back();
+        stack.pop_back();
+
+        auto const& n = nodes[idx];
+        if (depth > geometry::bvh::maxdepth)
+            return false;
+
+        if (n.leaf())
+        {
+            for (uint32 i(n.first); i < n.first + n.count; ++i)
+                if (i >= prims.size() || prims[i] >= boxes.size() || seen[prims[i]]++ || !inside(boxes[prims[i]], n.bounds))
+                    return false;
+            continue;
+        }
+
+        for (uint32 c : { n.first, n.first + 1 })
+        {
+            if (c >= nodes.size() || !inside(nodes[c].bounds, n.bounds))
+                return false;
+            stack.push_back({ c, depth + 1 });
+        }
+    }
+
+    return std::ranges::all_of(seen, [](uint8 s) { return s == 1; });
+}
+
+// boxes of particles spread through a cube, the size of an sph frame
+std::vector<geometry::aabb> particleboxes(uint count, float radius, stdx::xoshiro256& rng)
+{
+    std::vector<geometry::aabb> res;
+    res.reserve(count);
+    for (uint i(0); i < count; ++i)
+    {
+        stdx::vec3 const c = { rng.uniformf(-1.f, 1.f), rng.uniformf(-1.f, 1.f), rng.uniformf(-1.f, 1.f) };
+        res.emplace_back(c - stdx::vec3::filled(radius), c + stdx::vec3::filled(radius));
+    }
+
+    return res;
+}
+
+// sah builds of the sample models and closest and any hit throughput for rays in and around them
+void bvh(report& r)
+{
+    constexpr uint numrays = 1 << 20, numchecked = 512;
+    stdx::xoshiro256 rng;
+    for (auto const& m : loadmeshes(r))
+    {
+        std::string const name = m.name + " (" + std::to_string(m.indices.size() / 3) + " triangles)";
+        auto const rays = randomrays(m, numrays, rng);
+
+        geometry::trianglebvh tree;
+        double const buildms = r.time([&]() { tree = geometry::trianglebvh(m.positions, m.indices); }, 3);
+
+        std::vector<std::optional<geometry::rayhit>> hits(numrays);
+        auto const anyhits = std::make_unique<bool[]>(numrays);
+        double const closestms = r.time([&]() { tree.closesthit(rays, hits); }, 3);
+        double const anyms = r.time([&]() { tree.anyhit(rays, std::span(anyhits.get(), numrays)); }, 3);
+
+        uint const numhits = uint(std::ranges::count_if(hits, [](auto const& h) { return h.has_value(); }));
+        r.value(name + " sah build", buildms, "ms");
+        r.value(name + " closest hit", numrays / (closestms * 1e3), "Mrays/s");
+        r.value(name + " any hit", numrays / (anyms * 1e3), "Mrays/s");
+        r.value(name + " rays that hit", 100.0 * numhits / numrays, "%");
+        r.check(matchesbruteforce(m, rays, hits, std::span<bool const>(anyhits.get(), numrays), numchecked), name + " hits match brute force for " + std::to_string(numchecked) + " rays");
+
+        auto const axis = axisrays(m, numchecked, rng);
+        tree.closesthit(axis, std::span(hits.data(), numchecked));
+        tree.anyhit(axis, std::span(anyhits.get(), numchecked));
+        r.check(matchesbruteforce(m, axis, hits, std::span<bool const>(anyhits.get(), numchecked), numchecked), name + " hits of axis parallel rays match brute force for " + std::to_string(numchecked) + " rays");
+    }
+}
+
+
+// the 8 wide tree against the binary one it is collapsed from, on the sample models and on leaves too big for a packet
+void bvh8(report& r)
+{
+    constexpr uint numrays = 1 << 20, numchecked = 512;
+    stdx::xoshiro256 rng;
+    for (auto const& m : loadmeshes(r))
+    {
+        std::string const name = m.name + " (" + std::to_string(m.indices.size() / 3) + " triangles)";
+        auto const rays = randomrays(m, numrays, rng);
+
+        geometry::trianglebvh const binary(m.positions, m.indices);
+        geometry::trianglebvh8 wide;
+        double const collapsems = r.time([&]() { wide = geometry::trianglebvh8(binary); }, 3);
+
+        std::vector<std::optional<geometry::rayhit>> binaryhits(numrays), widehits(numrays);
+        auto const anyhits = std::make_unique<bool[]>(numrays);
+        double const binaryms = r.time([&]() { binary.closesthit(rays, binaryhits); }, 3);
+        double const widems = r.time([&]() { wide.closesthit(rays, widehits); }, 3);
+        double const binaryanyms = r.time([&]() { binary.anyhit(rays, std::span(anyhits.get(), numrays)); }, 3);
+        double const wideanyms = r.time([&]() { wide.anyhit(rays, std::span(anyhits.get(), numrays)); }, 3);
+
+        r.value(name + " collapse", collapsems, "ms");
+        r.value(name + " binary closest hit", numrays / (binaryms * 1e3), "Mrays/s");
+        r.value(name + " 8 wide closest hit", numrays / (widems * 1e3), "Mrays/s");
+        r.value(name + " binary any hit", numrays / (binaryanyms * 1e3), "Mrays/s");
+        r.value(name + " 8 wide any hit", numrays / (wideanyms * 1e3), "Mrays/s");
+
+        // traversal steps of closest hit queries, a binary node tests 2 boxes and a leaf up to 4 triangles one at a time
+        // an 8 wide node tests up to 8 boxes and a leaf up to 8 triangles at once
+        geometry::raystats binarystats, widestats;
+        constexpr uint numcounted = 1 << 16;
+        for (uint i(0); i < numcounted; ++i)
+        {
+            binary.closesthit(rays[i], binarystats);
+            wide.closesthit(rays[i], widestats);
+        }
+
+        r.value(name + " binary nodes per ray", double(binarystats.nodes) / numcounted, "");
+        r.value(name + " binary leaves per ray", double(binarystats.leaves) / numcounted, "");
+        r.value(name + " 8 wide nodes per ray", double(widestats.nodes) / numcounted, "");
+        r.value(name + " 8 wide leaves per ray", double(widestats.leaves) / numcounted, "");
+
+        bool same = true;
+        for (uint i(0); i < numrays; ++i)
+            same = same && binaryhits[i].has_value() == widehits[i].has_value() && (!binaryhits[i] || std::abs(binaryhits[i]->t - widehits[i]->t) <= 1e-5f * std::max(1.f, binaryhits[i]->t));
+
+        r.check(same, name + " 8 wide hits match the binary tree's for 1M rays");
+        r.check(matchesbruteforce(m, rays, widehits, std::span<bool const>(anyhits.get(), numrays), numchecked), name + " 8 wide hits match brute force for " + std::to_string(numchecked) + " rays");
+    }
+
+    // triangles sharing a box diagonal all have the same bounds, so the sah build can't split them and leaves them in one leaf
+    for (uint count : { 12u, 40u, 200u })
+    {
+        mesh fan;
+        fan.positions = { { -1.f, -1.f, -1.f }, { 1.f, 1.f, 1.f } };
+        for (uint32 t(0); t < count; ++t)
+        {
+            fan.positions.push_back({ rng.uniformf(-1.f, 1.f), rng.uniformf(-1.f, 1.f), rng.uniformf(-1.f, 1.f) });
+            fan.indices.insert(fan.indices.end(), { { 0, 0, 0 }, { 1, 0, 0 }, { t + 2, 0, 0 } });
+        }
+
+        geometry::trianglebvh const binary(fan.positions, fan.indices, count);
+        uint32 largest = 0;
+        for (auto const& n : binary.hierarchy().nodes())
+            largest = std::max(largest, n.count);
+
+        geometry::trianglebvh8 const wide(binary);
+        auto const rays = randomrays(fan, 4096, rng);
+        std::vector<std::optional<geometry::rayhit>> hits(rays.size());
+        auto const anyhits = std::make_unique<bool[]>(rays.size());
+        wide.closesthit(rays, hits);
+        wide.anyhit(rays, std::span(anyhits.get(), rays.size()));
+
+        std::string const leaf = "a leaf of " + std::to_string(largest) + " triangles";
+        r.check(largest == count, std::to_string(count) + " triangles with the same bounds build " + leaf);
+        r.check(matchesbruteforce(fan, rays, hits, std::span<bool const>(anyhits.get(), rays.size()), uint(rays.size())), "8 wide hits match brute force with " + leaf + " in " + std::to_string(wide.packets().size()) + " packets");
+    }
+}
+
+
+// sah against linear builds of 1M boxes for as many threads as the job system has, doubling from one
+void lbvh(report& r)
+{
+    constexpr uint count = 1 << 20;
+    stdx::xoshiro256 rng;
+    auto const boxes = particleboxes(count, 0.002f, rng);
+
+    auto& jobs = stdx::jobsystem::get();
+    std::vector<uint> threadcounts;
+    for (uint threads(1); threads < jobs.numthreads(); threads *= 2)
+        threadcounts.push_back(threads);
+    threadcounts.push_back(jobs.numthreads());
+
+    for (uint threads : threadcounts)
+    {
+        jobs.limitthreads(threads);
+        std::string const suffix = " (1M boxes, " + std::to_string(threads) + (threads == 1 ? " thread)" : " threads)");
+        r.value("sah build" + suffix, r.time([&]() { r.keep(float(geometry::bvh(boxes).nodes().size())); }, 3), "ms");
+        r.value("linear build, 30 bit codes" + suffix, r.time([&]() { r.keep(float(geometry::bvh::linear(boxes, 10).nodes().size())); }, 3), "ms");
+        r.value("linear build, 63 bit codes" + suffix, r.time([&]() { r.keep(float(geometry::bvh::linear(boxes, 21).nodes().size())); }, 3), "ms");
+    }
+
+    jobs.limitthreads(0);
+
+    geometry::bvh const sah(boxes), linear30 = geometry::bvh::linear(boxes, 10), linear63 = geometry::bvh::linear(boxes, 21);
+    r.value("sah build sah cost", sah.sahcost(), "");
+    r.value("linear build, 30 bit codes sah cost", linear30.sahcost(), "");
+    r.value("linear build, 63 bit codes sah cost", linear63.sahcost(), "");
+    r.check(validbvh(sah, boxes) && validbvh(linear30, boxes) && validbvh(linear63, boxes), "sah and linear builds hold every box once inside bounds that contain it");
+
+    // every box on the same spot gives every primitive the same morton code, only the index bits tell them apart
+    std::vector<geometry::aabb> const same(count / 16, geometry::aabb(stdx::vec3::filled(0.f), stdx::vec3::filled(1.f)));
+    r.check(validbvh(geometry::bvh::linear(same, 10), same), "linear build of 64k coincident boxes is valid");
+}
+
+
+// a ballistic dam break: 100k particles under gravity alone fall into a unit box and bounce off its walls, refitting against rebuilding every frame
+// there are no fluid forces, only sphintro's time step is borrowed
+void refit(report& r)
+{
+    constexpr uint count = 100000, numframes = 120;
+    constexpr float radius = 0.01f, dt = 0.04f;
+    stdx::xoshiro256 rng;
+    std::vector<stdx::vec3> positions(count), velocities(count);
+    for (uint i(0); i < count; ++i)
+    {
+        positions[i] = { rng.uniformf(-1.f, 0.f), rng.uniformf(-1.f, 1.f), rng.uniformf(-1.f, 1.f) };
+        velocities[i] = { rng.uniformf(-0.1f, 0.1f), rng.uniformf(-0.1f, 0.1f), rng.uniformf(-0.1f, 0.1f) };
+    }
+
+    std::vector<geometry::aabb> boxes(count);
+    auto const step = [&]()
+    {
+        for (uint i(0); i < count; ++i)
+        {
+            velocities[i][1] -= 9.8f * dt;
+            positions[i] = positions[i] + velocities[i] * dt;
+            for (uint a(0); a < 3; ++a)
+            {
+                if (std::abs(positions[i][a]) > 1.f)
+                {
+                    positions[i][a] = std::clamp(positions[i][a], -1.f, 1.f);
+                    velocities[i][a] *= -0.5f;
+                }
+            }
+
+            boxes[i] = { positions[i] - stdx::vec3::filled(radius), positions[i] + stdx::vec3::filled(radius) };
+        }
+    };
+
+    step();
+    geometry::bvh tree(boxes);
+    step();
+
+    double const refitms = r.time([&]() { r.keep(tree.refit(boxes)); });
+    double const sahms = r.time([&]() { r.keep(float(geometry::bvh(boxes).nodes().size())); }, 3);
+    double const linearms = r.time([&]() { r.keep(float(geometry::bvh::linear(boxes).nodes().size())); }, 3);
+    r.value("refit (100k particles)", refitms, "ms");
+    r.value("sah rebuild (100k particles)", sahms, "ms");
+    r.value("linear rebuild (100k particles)", linearms, "ms");
+    r.check(validbvh(tree, boxes), "a refitted tree holds every moved box inside its bounds");
+
+    // update refits every frame and rebuilds past 1.5 times the cost after the last build
+    uint rebuilds = 0;
+    float maxgrowth = 1.f, maxrefitted = 1.f;
+    auto const start = std::chrono::steady_clock::now();
+    for (uint f(0); f < numframes; ++f)
+    {
+        step();
+        bool const rebuilt = tree.update(boxes, 1.5f);
+        rebuilds += rebuilt ? 1 : 0;
+        maxgrowth = std::max(maxgrowth, tree.lastgrowth());
+        maxrefitted = std::max(maxrefitted, rebuilt ? 1.f : tree.lastgrowth());
+    }
+
+    double const updatems = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    r.value("frames", double(numframes), "");
+    r.value("rebuilds by update past 1.5x sah cost", double(rebuilds), "");
+    r.value("largest sah cost growth of a refit", maxgrowth, "x");
+    r.value("step and update per frame", updatems / numframes, "ms");
+    r.check(rebuilds > 0 && maxgrowth > 1.5f, "the ballistic dam break grows the sah cost far enough for update to rebuild");
+    r.check(maxrefitted <= 1.5f, "update never keeps a refitted tree past 1.5x its built sah cost");
+    r.check(validbvh(tree, boxes), "the tree after the last update holds every box inside its bounds");
+}
+
+
+// point cloud bounds and 8 wide box queries against the scalar loops they replace, every mask checked box by box
+void aabbset(report& r)
+{
+    stdx::xoshiro256 rng;
+
+    // an odd count, so the reduction has a tail past its last 8 points
+    constexpr uint numpoints = (1 << 22) + 5;
+    std::vector<stdx::vec3> points(numpoints);
+    for (auto& p : points)
+        p = { rng.uniformf(-10.f, 10.f), rng.uniformf(-1.f, 1.f), rng.uniformf(0.f, 100.f) };
+
+    geometry::aabb scalar, batched;
+    double const scalarms = r.time([&]()
+    {
+        scalar = { stdx::vec3::filled(std::numeric_limits<float>::max()), stdx::vec3::filled(std::numeric_limits<float>::lowest()) };
+        for (auto const& p : points)
+            scalar += p;
+    });
+
+    stdx::jobsystem::get().limitthreads(1);
+    double const onethreadms = r.time([&]() { batched = geometry::bounds(points); });
+    stdx::jobsystem::get().limitthreads(0);
+    double const batchedms = r.time([&]() { batched = geometry::bounds(points); });
+
+    r.value("aabb += per point (4M points)", scalarms, "ms");
+    r.value("bounds on one thread (4M points)", onethreadms, "ms");
+    r.value("bounds (4M points)", batchedms, "ms");
+    r.check(std::ranges::equal(scalar.min_pt, batched.min_pt) && std::ranges::equal(scalar.max_pt, batched.max_pt), "bounds equals the per point loop exactly");
+
+    auto const empty = geometry::bounds({});
+    r.check(empty.min_pt[0] > empty.max_pt[0] && empty.min_pt[1] > empty.max_pt[1] && empty.min_pt[2] > empty.max_pt[2], "bounds of no points is empty");
+
+    // an odd count again, so the last block has padding lanes that must never be set
+    constexpr uint numboxes = (1 << 20) + 3, numqueries = 16;
+    auto const boxes = particleboxes(numboxes, 0.05f, rng);
+    geometry::aabbset const set(boxes);
+    std::vector<uint8> masks(set.numblocks()), expected(set.numblocks());
+
+    auto const run = [&](std::string const& what, auto&& batch, auto&& single)
+    {
+        // batch picks the next query, the scalar loop tests the current one and fills expected like batch fills masks
+        batch();
+        auto const scalarloop = [&]()
+        {
+            std::ranges::fill(expected, uint8(0));
+            for (uint i(0); i < numboxes; ++i)
+                expected[i / 8] |= single(boxes[i]) ? uint8(1u << (i % 8)) : uint8(0);
+        };
+
+        double const loopms = r.time(scalarloop, 3);
+        double const setms = r.time(batch, 3);
+        r.value(what + ", loop over aabbs (1M boxes)", loopms, "ms");
+        r.value(what + ", aabbset (1M boxes)", setms, "ms");
+
+        bool same = true;
+        uint hits = 0;
+        for (uint q(0); q < numqueries; ++q)
+        {
+            batch();
+            scalarloop();
+            same = same && masks == expected;
+            for (auto m : masks)
+                hits += std::popcount(m);
+        }
+
+        r.value(what + ", boxes hit per query", double(hits) / numqueries, "");
+        r.check(same, what + " masks match the scalar test for " + std::to_string(numqueries) + " queries");
+    };
+
+    stdx::vec3 pt;
+    auto const newpoint = [&]() { pt = { rng.uniformf(-1.f, 1.f), rng.uniformf(-1.f, 1.f), rng.uniformf(-1.f, 1.f) }; };
+    run("point containment", [&]() { newpoint(); set.contains(pt, masks); }, [&](geometry::aabb const& b)
+    {
+        return b.min_pt[0] <= pt[0] && pt[0] <= b.max_pt[0] && b.min_pt[1] <= pt[1] && pt[1] <= b.max_pt[1] && b.min_pt[2] <= pt[2] && pt[2] <= b.max_pt[2];
+    });
+
+    geometry::aabb query;
+    auto const newbox = [&]() { newpoint(); query = { pt - stdx::vec3::filled(0.1f), pt + stdx::vec3::filled(0.1f) }; };
+    run("box overlap", [&]() { newbox(); set.overlaps(query, masks); }, [&](geometry::aabb const& b)
+    {
+        bool res = true;
+        for (uint a(0); a < 3; ++a)
+            res = res && b.min_pt[a] <= query.max_pt[a] && query.min_pt[a] <= b.max_pt[a];
+        return res;
+    });
+
+    geometry::ray ray;
+    stdx::vec3 invdir;
+    auto const newray = [&]()
+    {
+        newpoint();
+        ray = geometry::ray(pt * 2.f, stdx::vec3{ rng.uniformf(-1.f, 1.f), rng.uniformf(-1.f, 1.f), rng.uniformf(-1.f, 1.f) }.normalized(), 3.f);
+        invdir = { 1.f / ray.dir[0], 1.f / ray.dir[1], 1.f / ray.dir[2] };
+    };
+
+    run("ray slabs", [&]() { newray(); set.intersect(ray, masks); }, [&](geometry::aabb const& b)
+    {
+        return geometry::bvh::intersect(b, ray.origin, invdir, ray.tmin, ray.tmax) != std::numeric_limits<float>::infinity();
+    });
+}
+
+}
@@ -0,0 +1,115 @@
+module;
+
+#include "simplemath/simplemath.h"
+
+module benchmarks;
+
+import stdxcore;
+import stdx;
+import random;
+import jobs;
+import beziermaths;
+import graphics;
+import std;
+
+namespace benchmarks
+{
+
+using vector3 = DirectX::SimpleMath::Vector3;
+
+// control point drags on a model bound to a lattice of cells x cells x cells quadratic cells
+// one drag at the centre and one next to it, then the model is checked against evaluating the lattice
+void ffd(report& r, mesh const& mesh, uint cells, stdx::xoshiro256& rng)
+{
+    gfx::model m;
+    m._vertices.positions = mesh.positions;
+    m._vertices.tbns = mesh.tbns;
+    m._indices = mesh.indices;
+
+    gfx::ffd<2> lattice(m, { cells, cells, cells });
+
+    // binding splits shared tbns, so the rest frames are the ones after it
+    auto const& rest = mesh.positions;
+    auto const resttbns = m._vertices.tbns;
+
+    vector3 lo(rest[0][0], rest[0][1], rest[0][2]), hi = lo;
+    for (auto const& p : rest)
+    {
+        lo = vector3::Min(lo, vector3(p[0], p[1], p[2]));
+        hi = vector3::Max(hi, vector3(p[0], p[1], p[2]));
+    }
+
+    vector3 const cellextent = (hi - lo) / float(cells);
+    auto const drag = [&](uint c, vector3 const& by) { lattice.movecontrolpoint(c, lattice.controlpoint(c) + by); return lattice.deform(m); };
+
+    // the centre control point is a corner of the 8 middle cells when there are several, the one next to it lies inside a single cell
+    // with one cell the centre is inside it and the other one is a corner, both reach every vertex
+    uint const mid = cells / 2, centre = lattice.dims()[0] / 2;
+    uint const inside = cells == 1 ? 0 : centre + 1;
+    uint cornertouched = 0, insidetouched = 0;
+    double const cornerms = r.time([&]() { cornertouched = drag(lattice.controlpointindex({ centre, centre, centre }), cellextent * 0.01f); });
+    double const insidems = r.time([&]() { insidetouched = drag(lattice.controlpointindex({ inside, inside, inside }), cellextent * 0.01f); });
+
+    uint cornerexpected = 0;
+    for (uint z(cells == 1 ? 0 : mid - 1); z <= mid && z < cells; ++z)
+        for (uint y(cells == 1 ? 0 : mid - 1); y <= mid && y < cells; ++y)
+            for (uint x(cells == 1 ? 0 : mid - 1); x <= mid && x < cells; ++x)
+                cornerexpected += lattice.numvertices({ x, y, z });
+
+    uint const insideexpected = lattice.numvertices({ inside / 2, inside / 2, inside / 2 });
+
+    uint const count = rest.size();
+    std::vector<vector3> evaluated(count);
+    double const evaluatems = r.time([&]()
+    {
+        stdx::parallel_for(stdx::range(count), [&](uint p) { evaluated[p] = lattice.evaluate(vector3(rest[p][0], rest[p][1], rest[p][2]))[0]; });
+    });
+
+    r.keep(evaluated[count / 2].x);
+
+    std::string const name = mesh.name + ", " + std::to_string(cells) + "^3 cells";
+    r.value("centre control point drag (" + name + ")", cornerms, "ms");
+    r.value("vertices visited by it (" + name + ")", double(cornertouched), "");
+    r.value("off centre control point drag (" + name + ")", insidems, "ms");
+    r.value("vertices visited by it (" + name + ")", double(insidetouched), "");
+    r.value("evaluating the lattice at every vertex (" + name + ")", evaluatems, "ms");
+
+    // a few more drags, then the incrementally deformed model has to match the lattice evaluated from scratch
+    for (uint i(0); i < 20; ++i)
+    {
+        uint const c = lattice.controlpointindex({ uint(rng.uniform(uint32(lattice.dims()[0]))), uint(rng.uniform(uint32(lattice.dims()[1]))), uint(rng.uniform(uint32(lattice.dims()[2]))) });
+        drag(c, cellextent * vector3(rng.uniformf(-0.2f, 0.2f), rng.uniformf(-0.2f, 0.2f), rng.uniformf(-0.2f, 0.2f)));
+    }
+
+    float poserr = 0.f, normalerr = 0.f;
+    for (auto const& idx : m._indices)
+    {
+        auto const [pos, du, dv, dw] = lattice.evaluate(vector3(rest[idx.pos][0], rest[idx.pos][1], rest[idx.pos][2]));
+        auto const& q = m._vertices.positions[idx.pos];
+        poserr = std::max(poserr, (pos - vector3(q[0], q[1], q[2])).Length());
+
+        // normals follow the cofactor of the model space jacobian
+        auto const& deformed = m._vertices.tbns[idx.tbn].normal;
+        auto const& rn = resttbns[idx.tbn].normal;
+        vector3 normal = dv.Cross(dw) * rn[0] + dw.Cross(du) * rn[1] + du.Cross(dv) * rn[2];
+        normal.Normalize();
+        normalerr = std::max(normalerr, (normal - vector3(deformed[0], deformed[1], deformed[2])).Length());
+    }
+
+    r.check(cornertouched == cornerexpected && insidetouched == insideexpected, "drags visit the vertices of the cells around the control point only (" + name + ")");
+    r.check(poserr < 1e-5f * (hi - lo).Length(), "drags match evaluating the lattice within 1e-5 of the model's size (" + name + ")");
+    r.check(normalerr < 1e-3f, "deformed normals match the lattice's jacobian within 1e-3 (" + name + ")");
+}
+
+// the sample models bound to a single cell, where every drag visits every vertex, and to a grid of 8 x 8 x 8 cells
+void ffd(report& r)
+{
+    stdx::xoshiro256 rng;
+    for (auto const& m : loadmeshes(r))
+    {
+        ffd(r, m, 1, rng);
+        ffd(r, m, 8, rng);
+    }
+}
+
+}
@@ -0,0 +1,102 @@
+export module benchmarks;
+
+import stdxcore;
+import vec;
+import graphicscore;
+import std;
+
+export namespace benchmarks
+{
+
+// `continuity -bench [filter]` runs every benchmark whose name contains filter without creating a window
+// timings and checks are written to out, returns the number of failed checks
+uint run(std::string_view filter, std::ostream& out);
+
+}
+
+namespace benchmarks
+{
+
+class report
+{
+public:
+    explicit report(std::ostream& _out) : out(_out) {}
+
+    // best of a few runs in milliseconds, after one run to warm caches up
+    template<typename f_t>
+    double time(f_t&& f, uint runs = 5)
+    {
+        f();
+        double best = std::numeric_limits<double>::max();
+        for (uint i(0); i < runs; ++i)
+        {
+            auto const start = std::chrono::steady_clock::now();
+            f();
+            best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+
+        return best;
+    }
+
+    void value(std::string_view what, double v, std::string_view unit);
+
+    // a line of its own for what a benchmark skipped or couldn't run
+    void note(std::string_view what);
+
+    // failed checks make run return non zero
+    void check(bool ok, std::string_view what);
+
+    // results of timed work are summed in here, so the optimizer can't drop the work
+    void keep(float v) { sink = sink + v; }
+
+    uint failures() const { return numfailures; }
+
+private:
+    std::ostream& out;
+    uint numfailures = 0;
+    volatile float sink = 0.f;
+};
+
+struct mesh
+{
+    std::string name;
+    std::vector<stdx::vec3> positions;
+    std::vector<gfx::tbn> tbns;
+    std::vector<gfx::index> indices;
+};
+
+// the obj files the samples use, relative to the working directory like theirs, models that aren't there are reported and skipped
+// tangent frames are summed per obj normal the way gfx::model does it and aren't orthonormalized yet
+std::vector<mesh> loadmeshes(report& r);
+
+// benchmarks.stdx.cpp
+void vec(report& r);
+void tbn(report& r);
+void jobs(report& r);
+void join(report& r);
+void grid(report& r);
+void random(report& r);
+void flathash(report& r);
+
+// benchmarks.beziermaths.cpp
+void triangle(report& r);
+void decasteljau(report& r);
+void soa(report& r);
+void volume(report& r);
+void bulkevaluate(report& r);
+void baked(report& r);
+void forwarddiff(report& r);
+void adaptive(report& r);
+void closestpoint(report& r);
+
+// benchmarks.geometry.cpp
+void bvh(report& r);
+void bvh8(report& r);
+void lbvh(report& r);
+void refit(report& r);
+void aabbset(report& r);
+
+// benchmarks.graphics.cpp
+void ffd(report& r);
+
+}
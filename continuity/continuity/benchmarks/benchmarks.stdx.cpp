@@ -0,0 +1,399 @@
+module benchmarks;
+
+import stdxcore;
+import stdx;
+import vec;
+import random;
+import flathash;
+import jobs;
+import graphicscore;
+import std;
+
+namespace benchmarks
+{
+
+// sse vec kernels against the per component loops they replaced
+void vec(report& r)
+{
+    constexpr uint count = 1 << 20;
+    stdx::xoshiro256 rng;
+    std::vector<stdx::vec3> a(count), b(count), res(count);
+    for (uint i(0); i < count; ++i)
+    {
+        a[i] = { rng.uniformf(-1.f, 1.f), rng.uniformf(-1.f, 1.f), rng.uniformf(-1.f, 1.f) };
+        b[i] = { rng.uniformf(0.5f, 2.f), rng.uniformf(0.5f, 2.f), rng.uniformf(0.5f, 2.f) };
+    }
+
+    using generic = stdx::simd::generickernels<3, float>;
+    double const genericms = r.time([&]()
+    {
+        for (uint i(0); i < count; ++i)
+        {
+            auto const v = generic::add(generic::mul(a[i], b[i]), generic::div(a[i], 3.f));
+            res[i] = stdx::vec3{ generic::div(generic::sub(v, b[i]), b[i]) };
+        }
+    });
+
+    double const simdms = r.time([&]()
+    {
+        for (uint i(0); i < count; ++i)
+            res[i] = ((a[i] * b[i] + a[i] / 3.f) - b[i]) / b[i];
+    });
+
+    r.keep(res[count / 2][0]);
+
+    r.value("generic a * b + a / 3 - b / b (1M vec3)", genericms, "ms");
+    r.value("sse a * b + a / 3 - b / b (1M vec3)", simdms, "ms");
+
+    float dotsum = 0.f;
+    double const genericdotms = r.time([&]() { dotsum = 0.f; for (uint i(0); i < count; ++i) dotsum += generic::dot(a[i], b[i]); });
+    r.keep(dotsum);
+    double const simddotms = r.time([&]() { dotsum = 0.f; for (uint i(0); i < count; ++i) dotsum += a[i].dot(b[i]); });
+    r.keep(dotsum);
+    r.value("generic dot (1M vec3)", genericdotms, "ms");
+    r.value("vec::dot (1M vec3)", simddotms, "ms");
+
+    // every operation has to round like the generic one, fused compound expressions aren't compared
+    bool same = true;
+    for (uint i(0); i < count; ++i)
+    {
+        same = same && std::ranges::equal(a[i] * b[i], generic::mul(a[i], b[i])) && std::ranges::equal(a[i] + b[i], generic::add(a[i], b[i]));
+        same = same && std::ranges::equal(a[i] / b[i], generic::div(a[i], b[i])) && std::ranges::equal(a[i] / 3.f, generic::div(a[i], 3.f));
+    }
+
+    r.check(same, "sse kernels round like the generic ones");
+}
+
+// gram-schmidt on the tangent frames of the largest sample model, as gfx::model does after loading
+// one vec temporary per sub expression against lazy expressions evaluated in a single pass
+void tbn(report& r)
+{
+    auto const meshes = loadmeshes(r);
+    if (meshes.empty())
+        return;
+
+    auto const& m = *std::ranges::max_element(meshes, {}, [](mesh const& m) { return m.tbns.size(); });
+    uint const count = m.tbns.size();
+    std::vector<gfx::tbn> eager(count), lazy(count);
+
+    double const eagerms = r.time([&]()
+    {
+        for (uint i(0); i < count; ++i)
+        {
+            auto const& [normal, tangent, bitangent] = m.tbns[i];
+            stdx::vec3 const n = normal.normalized();
+            stdx::vec3 const t = (tangent - tangent.dot(n) * n).normalized();
+            stdx::vec3 const b = (bitangent - bitangent.dot(n) * n - bitangent.dot(t) * t).normalized();
+            eager[i] = { n, t, b };
+        }
+    });
+
+    double const lazyms = r.time([&]()
+    {
+        for (uint i(0); i < count; ++i)
+        {
+            auto const& [normal, tangent, bitangent] = m.tbns[i];
+            stdx::vec3 const n = normal.normalized();
+            stdx::vec3 const t = (stdx::lazy(tangent) - tangent.dot(n) * stdx::lazy(n)).normalized();
+            stdx::vec3 const b = (stdx::lazy(bitangent) - bitangent.dot(n) * stdx::lazy(n) - bitangent.dot(t) * stdx::lazy(t)).normalized();
+            lazy[i] = { n, t, b };
+        }
+    });
+
+    r.keep(eager[count / 2].tangent[0] + lazy[count / 2].tangent[0]);
+
+    std::string const frames = " (" + std::to_string(count) + " tbns of " + m.name + ")";
+    r.value("eager vec expressions" + frames, eagerms, "ms");
+    r.value("lazy vec expressions" + frames, lazyms, "ms");
+
+    float maxerr = 0.f;
+    for (uint i(0); i < count; ++i)
+    {
+        maxerr = std::max(maxerr, (eager[i].tangent - lazy[i].tangent).length());
+        maxerr = std::max(maxerr, (eager[i].bitangent - lazy[i].bitangent).length());
+    }
+
+    r.check(maxerr < 1e-5f, "lazy and eager tangent frames agree within 1e-5");
+}
+
+// parallel_for and parallel_reduce with 1 up to every thread, capped with limitthreads
+// each element does a few dozen flops, so the loops are bound by compute rather than memory bandwidth
+void jobs(report& r)
+{
+    constexpr uint count = 1 << 22;
+    std::vector<float> in(count), out(count);
+    stdx::xoshiro256 rng;
+    for (auto& v : in)
+        v = rng.uniformf();
+
+    auto const work = [](float x)
+    {
+        for (uint k(0); k < 8; ++k)
+            x = x * 0.5f + std::sqrt(x + 1.f);
+
+        return x;
+    };
+
+    auto& system = stdx::jobsystem::get();
+    uint const numthreads = system.numthreads();
+
+    double fsingle = 0., rsingle = 0., reference = 0.;
+    bool deterministic = true;
+    for (uint threads(1); threads <= numthreads; ++threads)
+    {
+        system.limitthreads(threads);
+        double const forms = r.time([&]() { stdx::parallel_for(stdx::range(count), [&](uint i) { out[i] = work(in[i]); }); }, 3);
+
+        // a fixed grain keeps the chunks and so the order of the sum the same at every thread count
+        double sum = 0.;
+        double const reducems = r.time([&]() { sum = stdx::parallel_reduce(stdx::range(count), 0., [&](uint i) { return double(work(in[i])); }, std::plus<>{}, count / 256); }, 3);
+
+        if (threads == 1)
+        {
+            fsingle = forms;
+            rsingle = reducems;
+            reference = sum;
+        }
+
+        deterministic = deterministic && sum == reference;
+
+        std::string const suffix = " (4M elements, " + std::to_string(threads) + (threads == 1 ? " thread)" : " threads)");
+        r.value("parallel_for" + suffix, forms, "ms");
+        r.value("parallel_for speedup" + suffix, fsingle / forms, "x");
+        r.value("parallel_reduce" + suffix, reducems, "ms");
+        r.value("parallel_reduce speedup" + suffix, rsingle / reducems, "x");
+    }
+
+    system.limitthreads(0);
+    r.keep(out[count / 2]);
+
+    r.check(deterministic, "parallel_reduce with a fixed grain sums to the same value at every thread count");
+}
+
+// bodies updated through a base interface, the way the samples join their body containers
+struct bodyinterface
+{
+    virtual ~bodyinterface() = default;
+    virtual void update(float dt) = 0;
+
+    stdx::vec3 position = {}, velocity = { 1.f, 2.f, 3.f };
+    uint visits = 0;
+};
+
+template<uint id>
+struct body final : bodyinterface
+{
+    void update(float dt) override { position = position + velocity * dt; ++visits; }
+
+    float extra[id + 1] = {};
+};
+
+// what dereferencing a join index did before iteration was made constant time: find the container by summing sizes, then walk the containers to it
+template<typename... args_t>
+bodyinterface* lookup(std::tuple<args_t&...>& data, std::array<uint, sizeof...(args_t)> const& sizes, uint idx)
+{
+    uint container = 0;
+    for (uint sum(0); container < sizes.size(); ++container)
+    {
+        sum += sizes[container];
+        if (idx < sum)
+        {
+            idx -= sum - sizes[container];
+            break;
+        }
+    }
+
+    bodyinterface* res = nullptr;
+    [&]<uint... n>(std::integer_sequence<uint, n...>) { ((n == container ? (res = &std::get<n>(data)[idx]) : res), ...); }(std::make_integer_sequence<uint, sizeof...(args_t)>{});
+    return res;
+}
+
+template<typename... args_t>
+void joinbodies(report& r, args_t&... containers)
+{
+    constexpr uint updates = 100;
+    constexpr float dt = 1e-3f;
+
+    auto j = stdx::makejoin<bodyinterface>(containers...);
+    uint const count = j.size();
+
+    std::tuple<args_t&...> data(containers...);
+    std::array<uint, sizeof...(args_t)> const sizes = { uint(containers.size())... };
+
+    double const lookupms = r.time([&]()
+    {
+        for (uint u(0); u < updates; ++u)
+            for (uint i(0); i < count; ++i)
+                lookup(data, sizes, i)->update(dt);
+    });
+
+    double const iteratems = r.time([&]() { for (uint u(0); u < updates; ++u) for (auto b : j) b->update(dt); });
+    double const foreachms = r.time([&]() { for (uint u(0); u < updates; ++u) j.for_each([](bodyinterface& b) { b.update(dt); }); });
+    double const parallelms = r.time([&]() { for (uint u(0); u < updates; ++u) stdx::parallel_for_each(j, [](bodyinterface& b) { b.update(dt); }); });
+
+    // time is per update of all bodies
+    auto const us = [](double ms) { return ms * 1000. / updates; };
+    std::string const suffix = " (" + std::to_string(count) + " bodies in " + std::to_string(sizeof...(args_t)) + " containers)";
+    r.value("indexed lookup per element, as join did before" + suffix, us(lookupms), "us");
+    r.value("join iteration" + suffix, us(iteratems), "us");
+    r.value("join::for_each" + suffix, us(foreachms), "us");
+    r.value("parallel_for_each" + suffix, us(parallelms), "us");
+
+    // every method ran its warmup and timed runs over every body
+    uint const expected = 4 * 6 * updates;
+    bool const once = ((std::ranges::all_of(containers, [expected](auto const& b) { return b.visits == expected; })) && ...);
+    r.check(once, "every method visits every body once per update" + suffix);
+}
+
+// 10k bodies spread over 3 and 5 containers of different types
+void join(report& r)
+{
+    std::vector<body<0>> spheres(4000);
+    std::vector<body<1>> boxes(3500);
+    std::vector<body<2>> capsules(2500);
+    joinbodies(r, spheres, boxes, capsules);
+
+    std::vector<body<0>> a(3000);
+    std::vector<body<1>> b(2500);
+    std::vector<body<2>> c(2000);
+    std::vector<body<3>> d(1500);
+    std::vector<body<4>> e(1000);
+    joinbodies(r, a, b, c, d, e);
+}
+
+// full grid sweeps reading a stencil of a scalar field, decoding every index against stepping it or walking in z-order
+void grid(report& r)
+{
+    // 65^3 sits in a 128^3 morton cube, most of whose octants are outside the grid
+    for (uint side : { 64u, 65u, 256u })
+    {
+        uint const d = side - 1;
+        std::vector<float> field(side * side * side);
+        stdx::xoshiro256 rng;
+        for (auto& f : field)
+            f = rng.uniformf();
+
+        auto const stencil = [&](stdx::grididx<2> const& idx)
+        {
+            uint const i = stdx::grididx<2>::to1d(d, idx);
+            float v = field[i];
+            if (idx[0] < d) v += field[i + 1];
+            if (idx[1] < d) v += field[i + side];
+            if (idx[2] < d) v += field[i + side * side];
+            return v;
+        };
+
+        float sum = 0.f;
+        double const decodems = r.time([&]() { sum = 0.f; for (uint i(0); i < field.size(); ++i) sum += stencil(stdx::grididx<2>::from1d(d, i)); }, 3);
+        r.keep(sum);
+        double const stepms = r.time([&]() { sum = 0.f; for (auto const& idx : stdx::grididx<2>::range(d)) sum += stencil(idx); }, 3);
+        r.keep(sum);
+        double const mortonms = r.time([&]() { sum = 0.f; stdx::mortonsweep<2>(d, [&](stdx::grididx<2> const& idx) { sum += stencil(idx); }); }, 3);
+        r.keep(sum);
+
+        std::string const size = std::to_string(side) + "^3";
+        r.value("from1d sweep " + size, decodems, "ms");
+        r.value("grididx::range sweep " + size, stepms, "ms");
+        r.value("mortonsweep " + size, mortonms, "ms");
+    }
+
+    bool roundtrip = true;
+    stdx::xoshiro256 rng;
+    for (uint i(0); i < 10000; ++i)
+    {
+        stdx::grididx<2> const idx(uint(rng.uniform(1u << 21)), uint(rng.uniform(1u << 21)), uint(rng.uniform(1u << 21)));
+        auto const back = stdx::mortonidx<2>::decode(stdx::mortonidx<2>::encode(idx));
+        roundtrip = roundtrip && std::ranges::equal(back, idx);
+    }
+
+    r.check(roundtrip, "morton codes decode to the index they were encoded from");
+
+    uint visits = 0;
+    bool increasing = true;
+    std::uint64_t last = 0;
+    std::vector<bool> seen(17 * 17 * 17);
+    stdx::mortonsweep<2>(16, [&](stdx::grididx<2> const& idx)
+    {
+        auto const code = stdx::mortonidx<2>::encode(idx);
+        increasing = increasing && (visits == 0 || code > last);
+        last = code;
+        seen[stdx::grididx<2>::to1d(16, idx)] = true;
+        ++visits;
+    });
+
+    r.check(visits == seen.size() && std::ranges::all_of(seen, std::identity{}), "mortonsweep visits every cell of a 17^3 grid once");
+    r.check(increasing, "mortonsweep visits cells in increasing morton code order");
+}
+
+// filling a buffer with uniform floats one draw at a time against four streams at once
+void random(report& r)
+{
+    constexpr uint count = 1 << 22;
+    std::vector<float> buffer(count);
+
+    double const scalarms = r.time([&]()
+    {
+        stdx::xoshiro256 rng;
+        for (auto& v : buffer)
+            v = rng.uniformf();
+    });
+
+    r.keep(buffer[count / 2]);
+
+    double const batchms = r.time([&]() { stdx::xoshiro256x4().fill(buffer); });
+    r.keep(buffer[count / 2]);
+
+    r.value("xoshiro256 uniformf (4M floats)", scalarms, "ms");
+    r.value("xoshiro256x4 fill (4M floats)", batchms, "ms");
+
+    // a buffer that isn't a multiple of 8 takes its tail from a partial step
+    std::vector<float> odd(count + 5);
+    stdx::xoshiro256x4().fill(odd);
+    r.check(std::ranges::equal(std::span(odd).first(count), buffer), "fill is deterministic and its tail doesn't disturb the sequence");
+    r.check(std::ranges::all_of(odd, [](float v) { return v >= 0.f && v < 1.f; }), "fill stays in [0, 1)");
+
+    double const mean = std::accumulate(buffer.begin(), buffer.end(), 0.0) / count;
+    r.check(std::abs(mean - 0.5) < 1e-3, "fill mean is 0.5");
+}
+
+// inserts, hits, misses and erases on the flat table against std::unordered_map with the same keys
+void flathash(report& r)
+{
+    constexpr uint count = 1 << 18;
+    stdx::xoshiro256 rng;
+    std::vector<uint64> keys(count), misses(count);
+    for (uint i(0); i < count; ++i)
+    {
+        keys[i] = rng();
+        misses[i] = rng();
+    }
+
+    auto const run = [&](auto& map, std::string_view name)
+    {
+        uint64 found = 0;
+        double const insertms = r.time([&]() { map.clear(); for (uint i(0); i < count; ++i) map[keys[i]] = i; }, 3);
+        double const hitms = r.time([&]() { found = 0; for (auto k : keys) found += map.find(k)->second; }, 3);
+        r.keep(float(found));
+        double const missms = r.time([&]() { found = 0; for (auto k : misses) found += map.find(k) == map.end() ? 0 : 1; }, 3);
+        r.keep(float(found));
+        double const erasems = r.time([&]() { for (uint i(0); i < count; ++i) map[keys[i]] = i; for (uint i(0); i < count; i += 2) map.erase(keys[i]); }, 3);
+
+        std::string const prefix(name);
+        r.value(prefix + " insert (256k)", insertms, "ms");
+        r.value(prefix + " find hit (256k)", hitms, "ms");
+        r.value(prefix + " find miss (256k)", missms, "ms");
+        r.value(prefix + " refill and erase half (256k)", erasems, "ms");
+    };
+
+    stdx::flathashmap<uint64, uint> flat;
+    std::unordered_map<uint64, uint> node;
+    run(flat, "flathashmap");
+    run(node, "std::unordered_map");
+
+    bool same = flat.size() == node.size();
+    for (auto const& [k, v] : node)
+        same = same && flat.contains(k) && flat.find(k)->second == v;
+    r.check(same, "flathashmap holds the same entries as std::unordered_map");
+}
+
+}
@@ -1,12 +1,15 @@
 ﻿module;
 
 #include "simplemath/simplemath.h"
+#include <immintrin.h>
 
 export module beziermaths;
 
 import stdxcore;
 import stdx;
 import vec;
+import jobs;
+import flathash;
 import std;
 
 export namespace beziermaths
@@ -15,12 +18,11 @@ export namespace beziermaths
 using vector2 = DirectX::SimpleMath::Vector2;
 using vector3 = DirectX::SimpleMath::Vector3;
 using vector4 = DirectX::SimpleMath::Vector4;
-using matrix = DirectX::SimpleMath::Matrix;
 using plane = DirectX::SimpleMath::Plane;
 
 using controlpoint = vector3;
 using curveeval = std::pair<vector3, vector3>;
-using voleval = std::pair<vector3, matrix>;
+using voleval = std::pair<vector3, stdx::matrix3x3>;
 using vertex = std::pair<vector3, vector3>;
 
 // these should be moved to geometry
@@ -69,6 +71,109 @@ inline constexpr vector3 qbasis(float t)
 // quadratic bezier 1st derivative basis
 inline constexpr vector3 dqbasis(float t) { return vector3(2 * (t - 1.f), 2.f - 4 * t, 2 * t); };
 
+// bernstein basis of degree n at t and its derivative
+// built up with the de casteljau recurrence, the derivative is n * (b[i - 1] - b[i]) of the degree n - 1 basis
+template<uint n>
+constexpr std::pair<std::array<float, n + 1>, std::array<float, n + 1>> bernstein(float t)
+{
+    std::array<float, n + 1> b{}, db{};
+    b[0] = 1.f;
+    for (uint k(1); k <= n; ++k)
+    {
+        if (k == n)
+        {
+            for (uint i(0); i <= n; ++i)
+                db[i] = n * ((i > 0 ? b[i - 1] : 0.f) - (i < n ? b[i] : 0.f));
+        }
+
+        for (uint i(k); i > 0; --i)
+            b[i] = b[i] * (1.f - t) + b[i - 1] * t;
+        b[0] *= (1.f - t);
+    }
+
+    return { b, db };
+}
+
+// bezier to power basis in s = t - 1/2 along one axis, m[i][j] is the weight of p[j] in the coefficient of s^i
+// around t = 0 the weights are C(d, i) C(i, j) (-1)^(i - j), which alternate and grow with d and lose precision much sooner
+template<uint d>
+inline constexpr auto powermatrix = []()
+{
+    std::array<std::array<float, d + 1>, d + 1> m{};
+    double binomial = 1.0;
+    for (uint j(0); j <= d; ++j)
+    {
+        // C(d, j) (1/2 + s)^j (1/2 - s)^(d - j) expanded in s
+        std::array<double, d + 1> poly{};
+        poly[0] = 1.0;
+        for (uint k(0); k < d; ++k)
+        {
+            double const sign = k < j ? 1.0 : -1.0;
+            for (uint i(k + 1); i > 0; --i)
+                poly[i] = poly[i] * 0.5 + poly[i - 1] * sign;
+            poly[0] *= 0.5;
+        }
+
+        for (uint i(0); i <= d; ++i)
+            m[i][j] = static_cast<float>(binomial * poly[i]);
+
+        binomial = binomial * (d - j) / (j + 1);
+    }
+
+    return m;
+}();
+
+// power basis coefficients of the points p[0], p[stride], ... written in place
+template<uint d>
+constexpr void topowerbasis(controlpoint* p, uint stride = 1)
+{
+    std::array<controlpoint, d + 1> line;
+    for (uint i(0); i <= d; ++i)
+        line[i] = p[i * stride];
+
+    for (uint i(0); i <= d; ++i)
+    {
+        controlpoint a = line[0] * powermatrix<d>[i][0];
+        for (uint j(1); j <= d; ++j)
+            a += line[j] * powermatrix<d>[i][j];
+
+        p[i * stride] = a;
+    }
+}
+
+inline vector3 madd(vector3 const& a, float t, vector3 const& b) { return a * t + b; }
+
+inline std::array<stdx::simd::f32pack, 3> madd(std::array<stdx::simd::f32pack, 3> const& a, stdx::simd::f32pack const& t, std::array<stdx::simd::f32pack, 3> const& b)
+{
+    return { stdx::simd::f32pack::fmadd(a[0], t, b[0]), stdx::simd::f32pack::fmadd(a[1], t, b[1]), stdx::simd::f32pack::fmadd(a[2], t, b[2]) };
+}
+
+// value and derivative of the degree d power basis polynomial a[0] + a[1]s + ... at s, one madd per coefficient for each
+template<uint d, typename point_t, typename scalar_t>
+requires (d >= 1)
+constexpr std::pair<point_t, point_t> horner(point_t const* a, scalar_t const& s)
+{
+    point_t value = madd(a[d], s, a[d - 1]);
+    point_t derivative = a[d];
+    for (uint i(d - 1); i-- > 0;)
+    {
+        derivative = madd(derivative, s, value);
+        value = madd(value, s, a[i]);
+    }
+
+    return { value, derivative };
+}
+
+template<uint d, typename point_t, typename scalar_t>
+constexpr point_t hornervalue(point_t const* a, scalar_t const& s)
+{
+    point_t value = a[d];
+    for (uint i(d); i-- > 0;)
+        value = madd(value, s, a[i]);
+
+    return value;
+}
+
 template<uint n>
 struct beziercurve
 {
@@ -125,11 +230,11 @@ struct decasteljau
     static beziertriangle<s> triangle(beziertriangle<n> const& patch, vector3 const& uvw)
     {
         beziertriangle<n - 1u> subpatch;
-        for (uint i = 0; i < subpatch.numcontrolpts; ++i)
+        uint i = 0;
+        for (auto const& idx : stdx::triindex<n - 1u>::all())
         {
             // barycentric interpolation to calculate subpatch controlnet
-            auto const& idx = stdx::triindex<n - 1u>::to3d(i);
-            subpatch.controlnet[i] = patch[stdx::triindex<n>::to1d(idx.j, idx.k)] * uvw.x + patch[stdx::triindex<n>::to1d(idx.j + 1, idx.k)] * uvw.y + patch[stdx::triindex<n>::to1d(idx.j, idx.k + 1)] * uvw.z;
+            subpatch.controlnet[i++] = patch[stdx::triindex<n>::to1d(idx.j, idx.k)] * uvw.x + patch[stdx::triindex<n>::to1d(idx.j + 1, idx.k)] * uvw.y + patch[stdx::triindex<n>::to1d(idx.j, idx.k + 1)] * uvw.z;
         }
 
         return decasteljau<n - 1u, s>::triangle(subpatch, uvw);
@@ -158,7 +263,7 @@ struct decasteljau
         using cubeidx = stdx::grididx<2>;
         static constexpr auto u0 = cubeidx(100);
         static constexpr auto u1 = cubeidx(10);
-        static constexpr auto u2 = cubeidx(100);
+        static constexpr auto u2 = cubeidx(1);
 
         auto const [t0, t2, t1] = uvw;
         beziervolume<n - 1u> subvol;
@@ -202,10 +307,11 @@ constexpr curveeval evaluate(beziercurve<n> const& curve, float t)
 template<uint n>
 constexpr vertex evaluate(beziertriangle<n> const& patch, vector3 const& uvw)
 {
+    // the reduced patch is linear, so it is indexed as degree 1
     auto const& triangle = decasteljau<n, 1>::triangle(patch, uvw);
-    controlpoint const& p010 = triangle[stdx::triindex<n>::to1d(1, 0)];
-    controlpoint const& p100 = triangle[stdx::triindex<n>::to1d(0, 0)];
-    controlpoint const& p001 = triangle[stdx::triindex<n>::to1d(0, 1)];
+    controlpoint const& p010 = triangle[stdx::triindex<1>::to1d(1, 0)];
+    controlpoint const& p100 = triangle[stdx::triindex<1>::to1d(0, 0)];
+    controlpoint const& p001 = triangle[stdx::triindex<1>::to1d(0, 1)];
 
     return { { p100 * uvw.x + p010 * uvw.y + p001 * uvw.z }, (p100 - p010).Cross(p001 - p010).Normalized() };
 }
@@ -226,25 +332,97 @@ template<uint n>
 requires(n >= 0)
 constexpr vector3 evaluate(beziervolume<n> const& vol, vector3 const& uwv) { return decasteljau<n, 0>::volume(vol, uwv).controlnet[0]; };
 
+// position and the partial derivatives along uwv.x, uwv.y and uwv.z
+// one pass over the control net, the bernstein weights of all four results are applied together
 template<uint n>
-requires(n >= 0)
-constexpr vector3 evaluatefast(beziervolume<n> const& vol, vector3 const& uwv) { return decasteljau<n, 0>::volume(vol, uwv).controlnet[0]; };
+std::array<vector3, 4> evaluatepartials(beziervolume<n> const& v, vector3 const& uwv)
+{
+    // same axis order as decasteljau::volume
+    auto const [t0, t2, t1] = uwv;
+    auto const [b0, d0] = bernstein<n>(t0);
+    auto const [b1, d1] = bernstein<n>(t1);
+    auto const [b2, d2] = bernstein<n>(t2);
+
+    // basis along the first axis in the lower half and its derivative in the upper half
+    std::array<__m256, n + 1> bd0;
+    for (uint i(0); i <= n; ++i)
+        bd0[i] = _mm256_setr_m128(_mm_set1_ps(b0[i]), _mm_set1_ps(d0[i]));
+
+    // position | d/dt0 and d/dt1 | d/dt2
+    __m256 posd0 = _mm256_setzero_ps();
+    __m256 d1d2 = _mm256_setzero_ps();
+    uint c = 0;
+    for (uint k(0); k <= n; ++k)
+    {
+        for (uint j(0); j <= n; ++j)
+        {
+            // a row along the first axis evaluated and differentiated at t0
+            __m256 row = _mm256_setzero_ps();
+            for (uint i(0); i <= n; ++i, ++c)
+            {
+                __m128 const cp = stdx::simd::f32lanes<3>::load(&v[c].x);
+                row = _mm256_fmadd_ps(bd0[i], _mm256_setr_m128(cp, cp), row);
+            }
+
+            posd0 = _mm256_fmadd_ps(_mm256_set1_ps(b1[j] * b2[k]), row, posd0);
+
+            __m256 const rowvalue = _mm256_permute2f128_ps(row, row, 0x00);
+            d1d2 = _mm256_fmadd_ps(_mm256_setr_m128(_mm_set1_ps(d1[j] * b2[k]), _mm_set1_ps(b1[j] * d2[k])), rowvalue, d1d2);
+        }
+    }
+
+    auto const tovector3 = [](__m128 v) { alignas(16) float r[4]; _mm_store_ps(r, v); return vector3(r[0], r[1], r[2]); };
+    return { tovector3(_mm256_castps256_ps128(posd0)), tovector3(_mm256_extractf128_ps(posd0, 1)), tovector3(_mm256_extractf128_ps(d1d2, 1)), tovector3(_mm256_castps256_ps128(d1d2)) };
+}
+
+// orientation from the normalized partial derivatives
+template<uint n>
+voleval evaluatefast(beziervolume<n> const& v, vector3 const& uwv)
+{
+    auto const [pos, du, dv, dw] = evaluatepartials(v, uwv);
+    auto const row = [](vector3 const& d) { vector3 const r = d.Normalized(); return stdx::vec3{ r.x, r.y, r.z }; };
+    return { pos, stdx::matrix3x3{ row(du), row(dv), row(dw) } };
+}
+
+// positions are volume parameters, normals are transformed by the partial derivatives at them
+// chunks of vertices are deformed on the job system, r may be vertices itself to deform in place
+template<uint n>
+void bulkevaluate(beziervolume<n> const& v, std::span<vertex const> vertices, std::span<vertex> r, uint grain = 0)
+{
+    stdx::cassert(r.size() >= vertices.size());
+    stdx::parallel_for(stdx::range(vertices.size()), [&v, vertices, r](uint i)
+    {
+        auto const [pos, du, dv, dw] = evaluatepartials(v, vertices[i].first);
+
+        // row vector times the 3x3 frame, what TransformNormal does without building a 4x4 matrix
+        auto const& nrm = vertices[i].second;
+        r[i] = { pos, vector3(du * nrm.x + dv * nrm.y + dw * nrm.z).Normalized() };
+    }, grain);
+}
+
+template<uint n>
+void bulkevaluate(beziervolume<n> const& v, std::span<vertex> vertices, uint grain = 0) { bulkevaluate(v, std::span<vertex const>(vertices), vertices, grain); }
 
-voleval evaluatefast(beziervolume<2> const& v, vector3 const& uwv);
-std::vector<vertex> bulkevaluate(beziervolume<2> const& v, std::vector<vertex> const& vertices);
+template<uint n>
+std::vector<vertex> bulkevaluate(beziervolume<n> const& v, std::vector<vertex> const& vertices)
+{
+    std::vector<vertex> ret(vertices.size());
+    bulkevaluate(v, std::span<vertex const>(vertices), std::span<vertex>(ret));
+    return ret;
+}
 
 template<uint n>
 constexpr beziertriangle<n + 1> elevate(beziertriangle<n> const& patch)
 {
     beziertriangle<n + 1> elevatedPatch;
-    for (int i = 0; i < elevatedPatch.numcontrolpts; ++i)
+    uint i = 0;
+    for (auto const& idx : stdx::triindex<n + 1>::all())
     {
-        auto const& idx = stdx::triindex<n + 1>::to3d(i);
         // subtraction will yield negative indices at times ignore such points
         auto const& term0 = idx.i == 0 ? vector3::Zero : patch.controlnet[stdx::triindex<n>::to1d(idx.j, idx.k)] * idx.i;
         auto const& term1 = idx.j == 0 ? vector3::Zero : patch.controlnet[stdx::triindex<n>::to1d(idx.j - 1, idx.k)] * idx.j;
         auto const& term2 = idx.k == 0 ? vector3::Zero : patch.controlnet[stdx::triindex<n>::to1d(idx.j, idx.k - 1)] * idx.k;
-        elevatedPatch.controlnet[i] = (term0 + term1 + term2) / (n + 1);
+        elevatedPatch.controlnet[i++] = (term0 + term1 + term2) / (n + 1);
     }
     return elevatedPatch;
 }
@@ -260,6 +438,17 @@ struct planarbezier
     using bezier_t = planarbezier<n, d>;
     using eval_t = std::array<vector3, n + 1>;
 
+    // structure of arrays views for batched evaluation, one span per coordinate
+    using paramsoa_t = std::array<std::span<float const>, n>;
+    using vec3soa_t = std::array<std::span<float>, 3>;
+    struct evalsoa_t
+    {
+        vec3soa_t position;
+
+        // same as eval_t[1..n], left empty to skip them
+        std::array<vec3soa_t, n> tangents;
+    };
+
     constexpr controlpoint& operator[](uint index) { return controlnet[index]; }
     constexpr controlpoint const& operator[](uint index) const { return controlnet[index]; }
     constexpr operator controlpoint() requires(d == 0) { return controlnet[0]; }
@@ -272,14 +461,14 @@ struct planarbezier
     static constexpr bezier_t identity(float dist)
     {
         bezier_t r;
-        for (auto i : stdx::range(numcontrolpts))
+        uint i = 0;
+        for (auto const& idx : stdx::grididx<n - 1>::range(d))
         {
             stdx::vec3 pos{};
-            auto const idx = stdx::grididx<n - 1>::from1d(d, i);
             for (auto c : stdx::range(std::min(n, (uint)3)))
                 pos[c] = idx[c] * dist;
 
-            r[i] = { pos[0], pos[1], pos[2] };
+            r[i++] = { pos[0], pos[1], pos[2] };
         }
 
         return r;
@@ -301,25 +490,46 @@ struct planarbezier
     // o──────┴──────┘
     // (0,0)
     // x is the new basis for the cell, to change basis to o from x just add
-    static constexpr controlpoint computesubcontrolpoint(uint subidx, planarbezier<n, d> const& b, typename planarbezier<n, d>::param_t const& p)
+    static constexpr controlpoint computesubcontrolpoint(stdx::grididx<n - 1> const& index, planarbezier<n, d> const& b, typename planarbezier<n, d>::param_t const& p)
     {
-        using grididx = stdx::grididx<n - 1>;
-
         // controlpoint idx(nd) for start of hypercube that determines subcontrolpoint is same as subcontrolpoint index
-        auto const index = grididx::from1d(d - 1, subidx);
+        uint const base = stdx::grididx<n - 1>::to1d(d, index);
 
         std::array<controlpoint, stdx::pown(2, n)> r;
         for (uint i(0); i < r.size(); ++i)
-            r[i] = b[grididx::to1d(d, grididx::from1d(1, i) + index)];
+            r[i] = b[base + cellcorners[i]];
 
         return stdx::nlerp<controlpoint, n - 1, 0>::lerp(r, p);
     }
 
-    // we can optimize this using simd
+    static constexpr controlpoint computesubcontrolpoint(uint subidx, planarbezier<n, d> const& b, typename planarbezier<n, d>::param_t const& p)
+    {
+        return computesubcontrolpoint(stdx::grididx<n - 1>::from1d(d - 1, subidx), b, p);
+    }
+
+    // offsets of the corners of a cell in the control net, they don't depend on the cell
+    static constexpr std::array<uint, stdx::pown(2u, n)> cellcorners = []()
+    {
+        std::array<uint, stdx::pown(2u, n)> r;
+        for (uint i(0); i < r.size(); ++i)
+            r[i] = stdx::grididx<n - 1>::to1d(d, stdx::grididx<n - 1>::from1d(1, i));
+        return r;
+    }();
+
     // todo : can recursion be avoided and still the evaluations kept generic
-    constexpr std::vector<eval_t> eval(std::vector<param_t> const& params)
+    constexpr std::vector<eval_t> eval(std::span<param_t const> params) const
     {
         std::vector<eval_t> r;
+        r.reserve(params.size());
+        for (auto const& p : params) r.push_back(eval(p));
+        return r;
+    }
+
+    // for transient evaluations, e.g. from stdx::framearena
+    std::pmr::vector<eval_t> eval(std::span<param_t const> params, std::pmr::memory_resource* mem) const
+    {
+        std::pmr::vector<eval_t> r(mem);
+        r.reserve(params.size());
         for (auto const& p : params) r.push_back(eval(p));
         return r;
     }
@@ -335,16 +545,98 @@ struct planarbezier
         if constexpr (n == 0)
             return res;
 
-        // the generic expression doesn't work for first dimension
-        res[1] = vector3(subbezier[1] - subbezier[0]).Normalized();
-        for (uint i(2); i <= n; ++i)
-            res[i] = vector3(subbezier[(i - 1) * 2] - subbezier[0]).Normalized();
+        // partial along i - 1, the edges of the linear cell along it lerped over the other dimensions
+        for (uint i(1); i <= n; ++i)
+        {
+            uint const bit = 1u << (i - 1);
+            std::array<controlpoint, numcellcorners / 2> edges;
+            for (uint c(0), e(0); c < numcellcorners; ++c)
+                if ((c & bit) == 0)
+                    edges[e++] = subbezier[c | bit] - subbezier[c];
+
+            for (uint dim(0), m(numcellcorners / 4); dim < n; ++dim)
+            {
+                if (dim == i - 1)
+                    continue;
+
+                for (uint j(0); j < m; ++j)
+                    edges[j] = edges[j * 2] + (edges[j * 2 + 1] - edges[j * 2]) * param[dim];
+                m /= 2;
+            }
+
+            res[i] = edges[0].Normalized();
+        }
 
         return res;
     }
 
+    // batched eval(param_t), stdx::simd::f32pack::width parameters at a time with one parameter per lane
+    // de casteljau runs on packs, so every lane shares the control net loads and the recursion
+    void eval(paramsoa_t const& params, evalsoa_t const& r) const requires(n >= 1 && d >= 1)
+    {
+        uint const count = params[0].size();
+        bool const withtangents = !r.tangents[0][0].empty();
+
+        // broadcast once, every lane group starts from a copy
+        auto const net = broadcast(controlnet);
+
+        std::array<packpoint_t, numcontrolpts> work;
+        for (uint b(0); b < count; b += pack_t::width)
+        {
+            uint const lanes = std::min(pack_t::width, count - b);
+
+            std::array<pack_t, n> t;
+            for (uint k(0); k < n; ++k)
+                t[k] = pack_t::loadpartial(params[k].data() + b, lanes);
+
+            work = net;
+            if constexpr (d > 1)
+                reducesoa<d>(work, t);
+
+            // the linear cell is now in the first 2^n entries
+            std::array<packpoint_t, numcellcorners> cell;
+            std::copy_n(work.begin(), numcellcorners, cell.begin());
+            storesoa(lerpsoa(cell, t), r.position, b, lanes);
+
+            if (!withtangents)
+                continue;
+
+            // same as the scalar eval, edges along i lerped over the other dimensions
+            for (uint i(0); i < n; ++i)
+            {
+                uint const bit = 1u << i;
+                std::array<packpoint_t, numcellcorners / 2> edges;
+                for (uint c(0), e(0); c < numcellcorners; ++c)
+                {
+                    if ((c & bit) != 0)
+                        continue;
+
+                    for (uint k(0); k < 3; ++k)
+                        edges[e][k] = work[c | bit][k] - work[c][k];
+                    ++e;
+                }
+
+                for (uint dim(0), m(numcellcorners / 4); dim < n; ++dim)
+                {
+                    if (dim == i)
+                        continue;
+
+                    for (uint j(0); j < m; ++j)
+                        for (uint k(0); k < 3; ++k)
+                            edges[j][k] = pack_t::fmadd(edges[j * 2 + 1][k] - edges[j * 2][k], t[dim], edges[j * 2][k]);
+                    m /= 2;
+                }
+
+                storenormalizedsoa(edges[0], r.tangents[i], b, lanes);
+            }
+        }
+    }
+
 private:
 
+    template<uint, uint>
+    friend struct bakedbezier;
+
     template<uint d, uint s>
     requires(d >= 0 && d >= s)  // degree cannot be negative or smaller than subdivision end degree
     struct realdecasteljau
@@ -352,9 +644,12 @@ private:
         using bezier_t = planarbezier<n, d>;
         static planarbezier<n, s> apply(bezier_t const& b, bezier_t::param_t const& p)
         {
+            // one statement per subcontrol point with constant indices, what computesubcontrolpoint does for every idx
             planarbezier<n, d - 1> subbezier;
-            for (uint i(0); i < subbezier.numcontrolpts; ++i)
-                subbezier[i] = b.computesubcontrolpoint(i, b, p);
+            [&]<uint... i>(std::integer_sequence<uint, i...>)
+            {
+                ((subbezier[i] = lerpcell<d, i>(b, p)), ...);
+            }(std::make_integer_sequence<uint, planarbezier<n, d - 1>::numcontrolpts>{});
 
             return realdecasteljau<d - 1, s>::apply(subbezier, p);
         }
@@ -366,30 +661,331 @@ private:
         using bezier_t = planarbezier<n, d>;
         static bezier_t apply(bezier_t const& b, bezier_t::param_t const& p) { return b; }
     };
+
+    static constexpr uint numcellcorners = stdx::pown(2u, n);
+
+    // control point indices of the cell under every subcontrol point, for the step from degree dd to dd - 1
+    template<uint dd>
+    static constexpr auto celltable = []()
+    {
+        std::array<std::array<uint, numcellcorners>, stdx::pown(dd, n)> r;
+        uint i = 0;
+        for (auto const& idx : stdx::grididx<n - 1>::range(dd - 1))
+        {
+            uint const base = stdx::grididx<n - 1>::to1d(dd, idx);
+            for (uint c(0); c < numcellcorners; ++c)
+                r[i][c] = base + planarbezier<n, dd>::cellcorners[c];
+            ++i;
+        }
+
+        return r;
+    }();
+
+    // subcontrol point i of a degree dd net, same lerp order as stdx::nlerp but in a + (b - a) * t form so each lerp is one fma
+    template<uint dd, uint i>
+    static controlpoint lerpcell(planarbezier<n, dd> const& b, param_t const& p)
+    {
+        static constexpr auto const& corners = celltable<dd>[i];
+
+        std::array<controlpoint, numcellcorners> c;
+        [&]<uint... k>(std::integer_sequence<uint, k...>)
+        {
+            ((c[k] = b[corners[k]]), ...);
+        }(std::make_integer_sequence<uint, numcellcorners>{});
+
+        for (uint dim(0), m(numcellcorners / 2); dim < n; ++dim, m /= 2)
+            for (uint j(0); j < m; ++j)
+                c[j] = c[j * 2] + (c[j * 2 + 1] - c[j * 2]) * p[dim];
+
+        return c[0];
+    }
+
+    using pack_t = stdx::simd::f32pack;
+    using packpoint_t = std::array<pack_t, 3>;
+
+    static std::array<packpoint_t, numcontrolpts> broadcast(std::array<controlpoint, numcontrolpts> const& points)
+    {
+        std::array<packpoint_t, numcontrolpts> r;
+        for (uint i(0); i < numcontrolpts; ++i)
+            r[i] = { pack_t::set1(points[i].x), pack_t::set1(points[i].y), pack_t::set1(points[i].z) };
+        return r;
+    }
+
+    // multilinear interpolation of a cell, same order as stdx::nlerp
+    static packpoint_t lerpsoa(std::array<packpoint_t, numcellcorners> c, std::array<pack_t, n> const& t)
+    {
+        for (uint dim(0), m(numcellcorners / 2); dim < n; ++dim, m /= 2)
+            for (uint i(0); i < m; ++i)
+                for (uint k(0); k < 3; ++k)
+                    c[i][k] = pack_t::fmadd(c[i * 2 + 1][k] - c[i * 2][k], t[dim], c[i * 2][k]);
+
+        return c[0];
+    }
+
+    // one de casteljau step from degree dd to dd - 1, down to the linear cell
+    // in place, a subcontrol point is written at or before the first corner it reads and after the ones read by earlier points
+    template<uint dd>
+    static void reducesoa(std::array<packpoint_t, numcontrolpts>& net, std::array<pack_t, n> const& t)
+    {
+        for (uint i(0); i < celltable<dd>.size(); ++i)
+        {
+            std::array<packpoint_t, numcellcorners> cell;
+            for (uint c(0); c < numcellcorners; ++c)
+                cell[c] = net[celltable<dd>[i][c]];
+
+            net[i] = lerpsoa(cell, t);
+        }
+
+        if constexpr (dd > 2)
+            reducesoa<dd - 1>(net, t);
+    }
+
+    static void storesoa(packpoint_t const& v, vec3soa_t const& r, uint b, uint lanes)
+    {
+        for (uint k(0); k < 3; ++k)
+            v[k].storepartial(r[k].data() + b, lanes);
+    }
+
+    static void storenormalizedsoa(packpoint_t dir, vec3soa_t const& r, uint b, uint lanes)
+    {
+        auto const len = pack_t::sqrt(pack_t::fmadd(dir[0], dir[0], pack_t::fmadd(dir[1], dir[1], dir[2] * dir[2])));
+        for (uint k(0); k < 3; ++k)
+            dir[k] = dir[k] / len;
+
+        storesoa(dir, r, b, lanes);
+    }
+
+    // value and partials from power basis coefficients, contracting the fastest axis first
+    // the partial along k branches off the value at axis k, later axes contract it like the value
+    template<typename point_t, typename params_t>
+    static std::array<point_t, n + 1> powereval(std::array<point_t, numcontrolpts> const& coeffs, params_t const& t, bool withpartials)
+    {
+        // [0] is the value, [k + 1] the partial along k
+        std::array<std::array<point_t, numcontrolpts / (d + 1)>, n + 1> chains;
+        for (uint k(0), count(numcontrolpts / (d + 1)); k < n; ++k, count /= d + 1)
+        {
+            // rows are contracted in place, row r is read before anything at or after r is written
+            point_t const* values = k == 0 ? coeffs.data() : chains[0].data();
+            for (uint r(0); r < count; ++r)
+            {
+                for (uint j(1); withpartials && j <= k; ++j)
+                    chains[j][r] = hornervalue<d>(chains[j].data() + r * (d + 1), t[k]);
+
+                auto const [value, derivative] = horner<d>(values + r * (d + 1), t[k]);
+                chains[0][r] = value;
+                if (withpartials)
+                    chains[k + 1][r] = derivative;
+            }
+        }
+
+        std::array<point_t, n + 1> r;
+        for (uint i(0); i <= n; ++i)
+            r[i] = chains[i][0];
+
+        return r;
+    }
+};
+
+// a planarbezier converted to the power basis around t = 1/2, both evals run horner, O(d) per axis instead of de casteljau's O(d^2)
+// holds a copy of the net taken at construction, so edits to the bezier afterwards need a new bake
+// power basis loses some precision as d grows, see powermatrix
+template<uint n, uint d>
+struct bakedbezier
+{
+    static_assert(n >= 1 && d >= 1);
+
+    using bezier_t = planarbezier<n, d>;
+    using param_t = typename bezier_t::param_t;
+    using eval_t = typename bezier_t::eval_t;
+    using paramsoa_t = typename bezier_t::paramsoa_t;
+    using evalsoa_t = typename bezier_t::evalsoa_t;
+
+    explicit bakedbezier(planarbezier<n, d> const& bezier) : coeffs(bezier.controlnet)
+    {
+        for (uint k(0), stride(1); k < n; ++k, stride *= d + 1)
+        {
+            // lines along k start where coordinate k is 0
+            for (uint s(0); s < bezier_t::numcontrolpts; ++s)
+                if ((s / stride) % (d + 1) == 0)
+                    topowerbasis<d>(coeffs.data() + s, stride);
+        }
+    }
+
+    // same as planarbezier::eval
+    eval_t eval(param_t const& param) const
+    {
+        param_t s;
+        for (uint k(0); k < n; ++k)
+            s[k] = param[k] - 0.5f;
+
+        auto res = bezier_t::powereval(coeffs, s, true);
+        for (uint i(1); i <= n; ++i)
+            res[i].Normalize();
+
+        return res;
+    }
+
+    void eval(paramsoa_t const& params, evalsoa_t const& r) const
+    {
+        using pack_t = typename bezier_t::pack_t;
+
+        uint const count = params[0].size();
+        bool const withtangents = !r.tangents[0][0].empty();
+        auto const net = bezier_t::broadcast(coeffs);
+        for (uint b(0); b < count; b += pack_t::width)
+        {
+            uint const lanes = std::min(pack_t::width, count - b);
+
+            std::array<pack_t, n> s;
+            for (uint k(0); k < n; ++k)
+                s[k] = pack_t::loadpartial(params[k].data() + b, lanes) - pack_t::set1(0.5f);
+
+            auto const e = bezier_t::powereval(net, s, withtangents);
+            bezier_t::storesoa(e[0], r.position, b, lanes);
+            for (uint i(0); withtangents && i < n; ++i)
+                bezier_t::storenormalizedsoa(e[i + 1], r.tangents[i], b, lanes);
+        }
+    }
+
+    // coefficient of s0^i0 s1^i1 ... at the index of control point (i0, i1, ...)
+    std::array<controlpoint, bezier_t::numcontrolpts> coeffs;
+};
+
+// evaluates a planarbezier on the tensor grid of parameters, params[k] are the values along dimension k
+// bernstein tables are built once per axis and the control net is contracted one axis at a time, so a sample costs
+// O(d) per axis instead of a full de casteljau. tangents are the normalized partial derivatives
+// results are appended in grididx order, the first dimension varies fastest
+template<uint n, uint d, typename container_t>
+requires (n >= 1)
+void evaluategrid(planarbezier<n, d> const& bezier, std::array<std::span<float const>, n> const& params, container_t& r)
+{
+    // a tensor of points with the first dimension stored fastest
+    struct tensor
+    {
+        std::array<uint, n> dims;
+        std::vector<vector3> data;
+    };
+
+    // replaces the control points along dimension k with their weighted sums, table holds d + 1 weights per parameter
+    auto const contract = [&params](tensor const& t, uint k, std::vector<float> const& table)
+    {
+        uint inner = 1, outer = 1;
+        for (uint i(0); i < k; ++i) inner *= t.dims[i];
+        for (uint i(k + 1); i < n; ++i) outer *= t.dims[i];
+
+        uint const m = params[k].size();
+        tensor res{ t.dims, std::vector<vector3>(inner * m * outer) };
+        res.dims[k] = m;
+        for (uint o(0); o < outer; ++o)
+        {
+            for (uint a(0); a < m; ++a)
+            {
+                vector3* dst = res.data.data() + (o * m + a) * inner;
+                for (uint c(0); c <= d; ++c)
+                {
+                    float const w = table[a * (d + 1) + c];
+                    vector3 const* src = t.data.data() + (o * (d + 1) + c) * inner;
+                    for (uint in(0); in < inner; ++in)
+                        dst[in] += src[in] * w;
+                }
+            }
+        }
+
+        return res;
+    };
+
+    std::array<std::vector<float>, n> basis, dbasis;
+    for (uint k(0); k < n; ++k)
+    {
+        for (auto const t : params[k])
+        {
+            auto const [b, db] = bernstein<d>(t);
+            basis[k].insert(basis[k].end(), b.begin(), b.end());
+            dbasis[k].insert(dbasis[k].end(), db.begin(), db.end());
+        }
+    }
+
+    // from the last dimension down, the partial along k branches off the position chain at k and shares the contractions before it
+    tensor pos{ stdx::vec<n, uint>::filled(d + 1), std::vector<vector3>(bezier.controlnet.begin(), bezier.controlnet.end()) };
+    std::array<tensor, n> partials;
+    for (uint k(n); k-- > 0;)
+    {
+        for (uint j(k + 1); j < n; ++j)
+            partials[j] = contract(partials[j], k, basis[k]);
+
+        partials[k] = contract(pos, k, dbasis[k]);
+        pos = contract(pos, k, basis[k]);
+    }
+
+    r.reserve(r.size() + pos.data.size());
+    for (uint i(0); i < pos.data.size(); ++i)
+    {
+        typename planarbezier<n, d>::eval_t e;
+        e[0] = pos.data[i];
+        for (uint k(0); k < n; ++k)
+            e[k + 1] = partials[k].data[i].Normalized();
+
+        r.push_back(e);
+    }
+}
+
+// triangles on the boundary of a bezier volume, params and positions per triangle vertex and the parameter space normal of every triangle pair
+template<uint d>
+struct boundarytriangles
+{
+    std::vector<typename planarbezier<3, d>::param_t> params;
+    std::vector<vector3> positions;
+    std::vector<vector3> normals;
 };
 
 template<uint d>
-auto tessellateboundary(planarbezier<3, d> const& bezier, uint intervals)
+boundarytriangles<d> tessellateboundary(planarbezier<3, d> const& bezier, uint intervals)
 {
-    using b_t = planarbezier<3, d>;
-    std::pair<std::vector<typename b_t::param_t>, std::vector<vector3>> r;
+    boundarytriangles<d> r;
     float const step = 1.f / intervals;
-    uint const nfacecells = stdx::pown(intervals, 2);
-    for (uint j(0); j < nfacecells; ++j)
+
+    std::vector<float> lattice;
+    for (uint i(0); i <= intervals; ++i)
+        lattice.push_back(i * step);
+
+    // each face is a lattice of the two other dimensions, evaluated once and shared by the cells
+    float const sides[2] = { 0.f, 1.f };
+    std::array<std::array<std::vector<typename planarbezier<3, d>::eval_t>, 2>, 3> faces;
+    for (uint i = 0; i < 3; ++i)
+    {
+        for (uint s = 0; s < 2; ++s)
+        {
+            std::array<std::span<float const>, 3> params{ lattice, lattice, lattice };
+            params[i] = std::span<float const>(sides + s, 1);
+            evaluategrid(bezier, params, faces[i][s]);
+        }
+    }
+
+    for (auto const& cell : stdx::grididx<1>::range(intervals - 1))
     {
-        stdx::vec2 const lb = stdx::grididx<1>::from1d(intervals - 1, j).castas<float>() / float(intervals);
+        stdx::vec2 const lb = cell.castas<float>() / float(intervals);
         auto const rb = lb + stdx::vec2{ step, 0.f };
         auto const rt = rb + stdx::vec2{ 0.f, step };
         auto const lt = lb + stdx::vec2{ 0.f, step };
 
+        // lattice indices of the corners in the same order as the quad
+        uint const l = cell[0] + cell[1] * (intervals + 1);
+        uint const corners[4] = { l, l + 1, l + intervals + 2, l + intervals + 1 };
+        uint const tris[6] = { corners[0], corners[1], corners[2], corners[0], corners[2], corners[3] };
+
         quad2 q{ lb, rb, rt, lt };
         for (uint i = 0; i < 3; ++i)
         {
-            for (auto v : q.to3(i, 0.f).tris()) r.first.push_back(v);
-            for (auto v : q.to3(i, 1.f).tris()) r.first.push_back(v);
+            for (uint s = 0; s < 2; ++s)
+            {
+                for (auto v : q.to3(i, sides[s]).tris()) r.params.push_back(v);
+                for (auto c : tris) r.positions.push_back(faces[i][s][c][0]);
+            }
 
-            r.second.push_back(-vector3(i));
-            r.second.push_back(vector3(i));
+            vector3 axis;
+            (&axis.x)[i] = 1.f;
+            r.normals.push_back(-axis);
+            r.normals.push_back(axis);
         }
     }
 
@@ -441,47 +1037,896 @@ auto tessellateboundary(planarbezier<3, d> const& bezier, uint intervals)
 //    return r;
 //}
 
+template<uint n, uint d, typename container_t>
+requires (!std::is_pointer_v<container_t>)
+void tessellate(planarbezier<n, d> const& bezier, uint intervals, container_t& r)
+{
+    // (intervals + 1)^n lattice points, the last row of each axis lands on 1
+    std::vector<float> lattice;
+    for (uint i(0); i <= intervals; ++i)
+        lattice.push_back(float(i) / float(intervals));
+
+    std::array<std::span<float const>, n> params;
+    params.fill(lattice);
+    evaluategrid(bezier, params, r);
+}
+
 template<uint n, uint d>
 auto tessellate(planarbezier<n, d> const& bezier, uint intervals)
 {
     std::vector<typename planarbezier<n, d>::eval_t> r;
-
-    uint const nsteps = stdx::pown(intervals + 1, n);
-    for (uint i(0); i < nsteps; ++i)
-    {
-        auto const p = stdx::grididx<n - 1>::from1d(intervals - 1, i).castas<float>() / float(intervals);
-        r.push_back(bezier.eval(p));
-    }
-
+    tessellate(bezier, intervals, r);
     return r;
 }
 
-bool firstclosest(vector3 p, vector3 p0, vector3 p1)
+template<uint n, uint d>
+auto tessellate(planarbezier<n, d> const& bezier, uint intervals, std::pmr::memory_resource* mem)
 {
-    return vector3::DistanceSquared(p, p0) < vector3::DistanceSquared(p, p1);
+    std::pmr::vector<typename planarbezier<n, d>::eval_t> r(mem);
+    tessellate(bezier, intervals, r);
+    return r;
 }
 
-using paramandpoint = std::pair<float, vector3>;
-paramandpoint closestpoint(planarbezier<1, 2> const& c, vector3 p)
+// steps a degree m polynomial curve by h with m additions per step, the table holds the value and its forward differences
+template<uint m>
+struct forwarddifferences
 {
-    static constexpr int maxitr = 4;
-    float tx = 0.5f;
-    float ty = 0.5f;
+    std::array<vector3, m + 1> table;
+
+    // stirling numbers of the second kind, [j][k] ways to split j items into k non empty sets
+    static constexpr auto stirling = []()
+    {
+        std::array<std::array<float, m + 1>, m + 1> r{};
+        r[0][0] = 1.f;
+        for (uint j(1); j <= m; ++j)
+            for (uint k(1); k <= j; ++k)
+                r[j][k] = k * r[j - 1][k] + r[j - 1][k - 1];
+        return r;
+    }();
 
-    vector3 xeval, yeval, xdeval, ydeval;
-    for (uint i(0); i < maxitr; ++i)
+    static constexpr float factorial(uint k) { return k <= 1 ? 1.f : k * factorial(k - 1); }
+
+    // rebuilds the table at t from the derivatives there, differencing evaluations at t, t + h, ... instead would cancel catastrophically
+    // with the taylor terms c[k] = p^(k)(t) h^k / k!, the differences are k! * sum(c[j] * stirling(j, k)) over j >= k
+    void anchor(std::array<vector3, m + 1> const& controlpts, float t, float h)
     {
-        auto const xeval = c.eval({ tx });
-        auto const yeval = c.eval({ ty });
+        std::array<vector3, m + 1> taylor;
+        auto cps = controlpts;
+        float scale = 1.f;
+        for (uint k(0); k <= m; ++k)
+        {
+            // de casteljau on the degree m - k derivative curve
+            auto tmp = cps;
+            for (uint r(1); r <= m - k; ++r)
+                for (uint i(0); i <= m - k - r; ++i)
+                    tmp[i] = tmp[i] * (1.f - t) + tmp[i + 1] * t;
 
-        tx = tx - ((p.x - xeval[0].x) / -xeval[1].x);
-        ty = ty - ((p.y - yeval[0].y) / -yeval[1].y);
+            taylor[k] = tmp[0] * scale;
+            scale *= h / (k + 1);
+
+            for (uint i(0); i < m - k; ++i)
+                cps[i] = (cps[i + 1] - cps[i]) * float(m - k);
+        }
+
+        for (uint k(0); k <= m; ++k)
+        {
+            table[k] = vector3::Zero;
+            for (uint j(k); j <= m; ++j)
+                table[k] += taylor[j] * (stirling[j][k] * factorial(k));
+        }
     }
 
-    if (!stdx::equals(tx, ty))
-        return firstclosest(p, xeval, yeval) ? paramandpoint{tx, xeval} : paramandpoint{ty, yeval};
-    
-    return { tx, xeval };
+    vector3 const& value() const { return table[0]; }
+    void step() { for (uint k(0); k < m; ++k) table[k] += table[k + 1]; }
+};
+
+template<uint d>
+constexpr std::array<vector3, d> derivativecontrolpts(std::array<vector3, d + 1> const& controlpts)
+{
+    std::array<vector3, d> r;
+    for (uint i(0); i < d; ++i)
+        r[i] = (controlpts[i + 1] - controlpts[i]) * float(d);
+    return r;
+}
+
+// uniform samples by forward differencing instead of evaluating every sample, same layout as tessellate
+// differences accumulate float error, so the tables are re-anchored to exact evaluations every anchorinterval steps
+// an anchorinterval of 0 anchors only at the start
+template<uint d, typename container_t>
+requires (d >= 1 && !std::is_pointer_v<container_t> && !std::is_arithmetic_v<container_t>)
+void tessellateforward(planarbezier<1, d> const& bezier, uint intervals, container_t& r, uint anchorinterval = 64)
+{
+    auto const dcontrolpts = derivativecontrolpts<d>(bezier.controlnet);
+    float const h = 1.f / intervals;
+
+    forwarddifferences<d> pos;
+    forwarddifferences<d - 1> tangent;
+    r.reserve(r.size() + intervals + 1);
+    for (uint i(0); i <= intervals; ++i)
+    {
+        if (i == 0 || (anchorinterval != 0 && i % anchorinterval == 0))
+        {
+            pos.anchor(bezier.controlnet, i * h, h);
+            tangent.anchor(dcontrolpts, i * h, h);
+        }
+
+        r.push_back({ pos.value(), tangent.value().Normalized() });
+        pos.step();
+        tangent.step();
+    }
+}
+
+// rows along the first dimension are forward differenced, every row starts from curves computed exactly at its v
+template<uint d, typename container_t>
+requires (d >= 1 && !std::is_pointer_v<container_t> && !std::is_arithmetic_v<container_t>)
+void tessellateforward(planarbezier<2, d> const& bezier, uint intervals, container_t& r, uint anchorinterval = 64)
+{
+    float const h = 1.f / intervals;
+    r.reserve(r.size() + (intervals + 1) * (intervals + 1));
+    for (uint j(0); j <= intervals; ++j)
+    {
+        // the row and its derivative along v are bezier curves in u
+        auto const [bv, dbv] = bernstein<d>(j * h);
+        std::array<vector3, d + 1> row{}, rowdv{};
+        for (uint l(0); l <= d; ++l)
+        {
+            for (uint i(0); i <= d; ++i)
+            {
+                row[i] += bezier[l * (d + 1) + i] * bv[l];
+                rowdv[i] += bezier[l * (d + 1) + i] * dbv[l];
+            }
+        }
+
+        auto const rowdu = derivativecontrolpts<d>(row);
+
+        forwarddifferences<d> pos, dv;
+        forwarddifferences<d - 1> du;
+        for (uint i(0); i <= intervals; ++i)
+        {
+            if (i == 0 || (anchorinterval != 0 && i % anchorinterval == 0))
+            {
+                pos.anchor(row, i * h, h);
+                du.anchor(rowdu, i * h, h);
+                dv.anchor(rowdv, i * h, h);
+            }
+
+            r.push_back({ pos.value(), du.value().Normalized(), dv.value().Normalized() });
+            pos.step();
+            du.step();
+            dv.step();
+        }
+    }
+}
+
+template<uint n, uint d>
+auto tessellateforward(planarbezier<n, d> const& bezier, uint intervals, uint anchorinterval = 64)
+{
+    std::vector<typename planarbezier<n, d>::eval_t> r;
+    tessellateforward(bezier, intervals, r, anchorinterval);
+    return r;
+}
+
+// indexed triangles, vertices are shared by all the triangles around them
+template<typename param_t>
+struct trimesh
+{
+    std::vector<param_t> params;
+    std::vector<vector3> positions;
+    std::vector<vector3> normals;
+    std::vector<uint32> indices;
+};
+
+// splits along dimension k at t, the halves cover [0, t] and [t, 1] of that dimension
+template<uint n, uint d>
+constexpr std::pair<planarbezier<n, d>, planarbezier<n, d>> split(planarbezier<n, d> const& b, uint k, float t)
+{
+    std::pair<planarbezier<n, d>, planarbezier<n, d>> r;
+    uint const stride = stdx::pown(d + 1, k);
+    for (uint s(0); s < planarbezier<n, d>::numcontrolpts; ++s)
+    {
+        // lines along k start where coordinate k is 0
+        if ((s / stride) % (d + 1) != 0)
+            continue;
+
+        std::array<controlpoint, d + 1> line;
+        for (uint i(0); i <= d; ++i)
+            line[i] = b[s + i * stride];
+
+        // first and last points of every de casteljau level are the control points of the halves
+        for (uint l(0); l <= d; ++l)
+        {
+            r.first[s + l * stride] = line[0];
+            r.second[s + (d - l) * stride] = line[d - l];
+            for (uint i(0); i < d - l; ++i)
+                line[i] = line[i] * (1.f - t) + line[i + 1] * t;
+        }
+    }
+
+    return r;
+}
+
+// polar form of the patch, de casteljau with a different parameter at every level
+template<uint n, uint m>
+controlpoint blossom(beziertriangle<n> const& patch, std::array<vector3, m> const& params)
+{
+    if constexpr (n == 0)
+        return patch[0];
+    else
+        return blossom(decasteljau<n, n - 1>::triangle(patch, params[m - n]), params);
+}
+
+// the patch over the parameter triangle a, b, c as a patch of its own, a is its u corner, b its v corner and c its w corner
+template<uint n>
+beziertriangle<n> subtriangle(beziertriangle<n> const& patch, vector3 const& a, vector3 const& b, vector3 const& c)
+{
+    beziertriangle<n> r;
+    uint i = 0;
+    for (auto const& idx : stdx::triindex<n>::all())
+    {
+        std::array<vector3, n> params;
+        std::fill_n(params.begin(), idx.i, a);
+        std::fill_n(params.begin() + idx.i, idx.j, b);
+        std::fill_n(params.begin() + idx.i + idx.j, idx.k, c);
+        r.controlnet[i++] = blossom(patch, params);
+    }
+
+    return r;
+}
+
+// bound on the distance of the patch from the two triangles through its corners
+// the net is compared to the bilinear patch of the corners, plus how far that bilinear patch bends away from its diagonal
+template<uint d>
+requires (d >= 1)
+float flatness(planarbezier<2, d> const& b)
+{
+    auto const& p00 = b[0];
+    auto const& p10 = b[d];
+    auto const& p01 = b[d * (d + 1)];
+    auto const& p11 = b[(d + 1) * (d + 1) - 1];
+
+    float r = 0.f;
+    uint i = 0;
+    for (auto const& idx : stdx::grididx<1>::range(d))
+    {
+        float const u = float(idx[0]) / d, v = float(idx[1]) / d;
+        r = std::max(r, vector3::Distance(b[i++], (p00 * (1.f - u) + p10 * u) * (1.f - v) + (p01 * (1.f - u) + p11 * u) * v));
+    }
+
+    return r + vector3(p00 - p10 - p01 + p11).Length() * 0.25f;
+}
+
+// bound on the distance of the patch from the triangle through its corners
+template<uint n>
+requires (n >= 1)
+float flatness(beziertriangle<n> const& patch)
+{
+    auto const& pu = patch[stdx::triindex<n>::to1d(0, 0)];
+    auto const& pv = patch[stdx::triindex<n>::to1d(n, 0)];
+    auto const& pw = patch[stdx::triindex<n>::to1d(0, n)];
+
+    float r = 0.f;
+    uint i = 0;
+    for (auto const& idx : stdx::triindex<n>::all())
+        r = std::max(r, vector3::Distance(patch[i++], (pu * float(idx.i) + pv * float(idx.j) + pw * float(idx.k)) / float(n)));
+
+    return r;
+}
+
+// cell of an adaptive subdivision, corners are counter clockwise in uv on a grid of 2^maxdepth cells per side
+struct dyadicleaf
+{
+    std::array<stdx::grididx<1>, 4> corners;
+    uint numcorners;
+};
+
+// every leaf corner that lies on the edge of another leaf goes into that leaf's outline, so neighbours that went deeper leave no t junctions
+// boundary points on the outer edges of the leaves, e.g. corners of a neighbouring patch's leaves, are put into outlines the same way
+// corner(c) returns the vertex of a grid corner, centre(u, v) adds a vertex at a point in grid units
+template<typename corner_t, typename centre_t>
+void stitch(std::vector<dyadicleaf> const& leaves, std::span<stdx::grididx<1> const> boundary, corner_t&& corner, centre_t&& centre, std::vector<uint32>& indices)
+{
+    using coord_t = stdx::grididx<1>;
+
+    // corners are shared, leaves next to each other evaluate them once
+    auto const key = [](coord_t const& c) { return (uint64(c[0]) << 32) | uint64(c[1]); };
+    stdx::flathashmap<uint64, uint32> corners;
+    auto const addcorner = [&](coord_t const& c)
+    {
+        if (auto const [it, inserted] = corners.try_emplace(key(c)); inserted)
+            it->second = corner(c);
+    };
+
+    for (auto const& leaf : leaves)
+        for (uint i(0); i < leaf.numcorners; ++i)
+            addcorner(leaf.corners[i]);
+
+    for (auto const& c : boundary)
+        addcorner(c);
+
+    // a finer neighbour along a -> b split the edge at its midpoint first, so halving finds all its corners in order
+    std::vector<uint32> outline;
+    auto const edge = [&corners, &outline, &key](auto const& self, coord_t const& a, coord_t const& b) -> void
+    {
+        if ((a[0] + b[0]) % 2 != 0 || (a[1] + b[1]) % 2 != 0)
+            return;
+
+        coord_t const mid((a[0] + b[0]) / 2, (a[1] + b[1]) / 2);
+        if (auto const it = corners.find(key(mid)); it != corners.end())
+        {
+            self(self, a, mid);
+            outline.push_back(it->second);
+            self(self, mid, b);
+        }
+    };
+
+    for (auto const& leaf : leaves)
+    {
+        outline.clear();
+        for (uint i(0); i < leaf.numcorners; ++i)
+        {
+            outline.push_back(corners.at(key(leaf.corners[i])));
+            edge(edge, leaf.corners[i], leaf.corners[(i + 1) % leaf.numcorners]);
+        }
+
+        if (outline.size() == leaf.numcorners)
+        {
+            indices.insert(indices.end(), { outline[0], outline[1], outline[2] });
+            if (leaf.numcorners == 4)
+                indices.insert(indices.end(), { outline[0], outline[2], outline[3] });
+
+            continue;
+        }
+
+        // fan from the centre, fanning from a corner would give slivers along the split edges
+        float cu = 0.f, cv = 0.f;
+        for (uint i(0); i < leaf.numcorners; ++i)
+        {
+            cu += float(leaf.corners[i][0]);
+            cv += float(leaf.corners[i][1]);
+        }
+
+        uint32 const mid = centre(cu / leaf.numcorners, cv / leaf.numcorners);
+        for (uint i(0); i < outline.size(); ++i)
+            indices.insert(indices.end(), { mid, outline[i], outline[(i + 1) % outline.size()] });
+    }
+}
+
+// eval(u, v) returns the param, position and normal of a vertex
+template<typename param_t, typename eval_t>
+trimesh<param_t> stitch(std::vector<dyadicleaf> const& leaves, uint maxdepth, eval_t&& eval)
+{
+    trimesh<param_t> r;
+    float const scale = 1.f / float(1u << maxdepth);
+    auto const addvertex = [&r, &eval, scale](float u, float v)
+    {
+        auto const [param, pos, nrm] = eval(u * scale, v * scale);
+        r.params.push_back(param);
+        r.positions.push_back(pos);
+        r.normals.push_back(nrm);
+        return static_cast<uint32>(r.positions.size() - 1);
+    };
+
+    stitch(leaves, {}, [&addvertex](stdx::grididx<1> const& c) { return addvertex(float(c[0]), float(c[1])); }, addvertex, r.indices);
+    return r;
+}
+
+template<uint d>
+void subdivide(planarbezier<2, d> const& patch, stdx::grididx<1> const& lo, stdx::grididx<1> const& hi, float tolerance, uint depth, std::vector<dyadicleaf>& leaves)
+{
+    if (depth == 0 || flatness(patch) <= tolerance)
+    {
+        leaves.push_back({ { lo, stdx::grididx<1>(hi[0], lo[1]), hi, stdx::grididx<1>(lo[0], hi[1]) }, 4 });
+        return;
+    }
+
+    stdx::grididx<1> const mid((lo[0] + hi[0]) / 2, (lo[1] + hi[1]) / 2);
+    auto const [left, right] = split(patch, 0, 0.5f);
+    auto const [leftbottom, lefttop] = split(left, 1, 0.5f);
+    auto const [rightbottom, righttop] = split(right, 1, 0.5f);
+    subdivide(leftbottom, lo, mid, tolerance, depth - 1, leaves);
+    subdivide(rightbottom, stdx::grididx<1>(mid[0], lo[1]), stdx::grididx<1>(hi[0], mid[1]), tolerance, depth - 1, leaves);
+    subdivide(lefttop, stdx::grididx<1>(lo[0], mid[1]), stdx::grididx<1>(mid[0], hi[1]), tolerance, depth - 1, leaves);
+    subdivide(righttop, mid, hi, tolerance, depth - 1, leaves);
+}
+
+// corners are the uv of the patch's u, v and w corners
+template<uint n>
+void subdivide(beziertriangle<n> const& patch, std::array<stdx::grididx<1>, 3> const& corners, float tolerance, uint depth, std::vector<dyadicleaf>& leaves)
+{
+    auto const& [a, b, c] = corners;
+    if (depth == 0 || flatness(patch) <= tolerance)
+    {
+        leaves.push_back({ { a, b, c }, 3 });
+        return;
+    }
+
+    auto const mid = [](stdx::grididx<1> const& x, stdx::grididx<1> const& y) { return stdx::grididx<1>((x[0] + y[0]) / 2, (x[1] + y[1]) / 2); };
+    auto const ab = mid(a, b), bc = mid(b, c), ca = mid(c, a);
+
+    // midpoint split, the middle triangle is turned by half a turn which keeps the winding
+    vector3 const pa(1.f, 0.f, 0.f), pb(0.f, 1.f, 0.f), pc(0.f, 0.f, 1.f);
+    vector3 const pab(0.5f, 0.5f, 0.f), pbc(0.f, 0.5f, 0.5f), pca(0.5f, 0.f, 0.5f);
+    subdivide(subtriangle(patch, pa, pab, pca), { a, ab, ca }, tolerance, depth - 1, leaves);
+    subdivide(subtriangle(patch, pab, pb, pbc), { ab, b, bc }, tolerance, depth - 1, leaves);
+    subdivide(subtriangle(patch, pca, pbc, pc), { ca, bc, c }, tolerance, depth - 1, leaves);
+    subdivide(subtriangle(patch, pbc, pca, pab), { bc, ca, ab }, tolerance, depth - 1, leaves);
+}
+
+// subdivides until every piece is within tolerance of its triangles, so flat regions get few triangles and curved ones many
+// pieces stop at maxdepth halvings regardless of tolerance
+template<uint d>
+requires (d >= 1)
+trimesh<stdx::vec2> tessellateadaptive(planarbezier<2, d> const& bezier, float tolerance, uint maxdepth = 10)
+{
+    std::vector<dyadicleaf> leaves;
+    uint const side = 1u << maxdepth;
+    subdivide(bezier, stdx::grididx<1>(0u, 0u), stdx::grididx<1>(side, side), tolerance, maxdepth, leaves);
+
+    // every vertex is an evaluation at a point of its own, horner is cheaper than de casteljau for each
+    bakedbezier<2, d> const baked(bezier);
+    return stitch<stdx::vec2>(leaves, maxdepth, [&baked](float u, float v)
+    {
+        auto const e = baked.eval({ u, v });
+        return std::tuple{ stdx::vec2{ u, v }, e[0], e[1].Cross(e[2]).Normalized() };
+    });
+}
+
+// params are uvw
+template<uint n>
+requires (n >= 1)
+trimesh<vector3> tessellateadaptive(beziertriangle<n> const& patch, float tolerance, uint maxdepth = 10)
+{
+    std::vector<dyadicleaf> leaves;
+    uint const side = 1u << maxdepth;
+    subdivide(patch, { stdx::grididx<1>(side, 0u), stdx::grididx<1>(0u, side), stdx::grididx<1>(0u, 0u) }, tolerance, maxdepth, leaves);
+
+    return stitch<vector3>(leaves, maxdepth, [&patch](float u, float v)
+    {
+        vector3 const uvw(u, v, std::max(0.f, 1.f - u - v));
+        auto const [pos, nrm] = evaluate(patch, uvw);
+        return std::tuple{ uvw, pos, nrm };
+    });
+}
+
+// the other side of a quad patch edge, edges are numbered v = 0, u = 1, v = 1, u = 0
+// edges run along increasing u or v, reversed neighbours run the shared edge the other way
+struct edgeneighbour
+{
+    uint32 patch = stdx::invalid<uint32>;
+    uint32 edge = 0;
+    bool reversed = false;
+};
+
+using patchadjacency = std::array<edgeneighbour, 4>;
+
+// vertex of a tessellated patch set, uv is on the patch it was evaluated on
+struct patchuv
+{
+    uint32 patch;
+    stdx::vec2 uv;
+};
+
+template<uint d>
+constexpr std::array<vector3, d + 1> edgecontrolpts(planarbezier<2, d> const& b, uint edge)
+{
+    std::array<vector3, d + 1> r;
+    for (uint i(0); i <= d; ++i)
+    {
+        uint const u = edge == 0 || edge == 2 ? i : (edge == 1 ? d : 0);
+        uint const v = edge == 1 || edge == 3 ? i : (edge == 2 ? d : 0);
+        r[i] = b[v * (d + 1) + u];
+    }
+
+    return r;
+}
+
+// patches share an edge when the control points of the edges match within tolerance, in the same or in reverse order
+// compares every pair of edges, meant for patch sets of tens to hundreds of patches
+template<uint d>
+requires (d >= 1)
+std::vector<patchadjacency> edgeadjacency(std::span<planarbezier<2, d> const> patches, float tolerance = 1e-6f)
+{
+    std::vector<patchadjacency> r(patches.size());
+    for (uint32 p(0); p < patches.size(); ++p)
+    {
+        for (uint32 e(0); e < 4; ++e)
+        {
+            auto const edge = edgecontrolpts(patches[p], e);
+            for (uint32 q(p + 1); q < patches.size() && r[p][e].patch == stdx::invalid<uint32>; ++q)
+            {
+                for (uint32 f(0); f < 4; ++f)
+                {
+                    if (r[q][f].patch != stdx::invalid<uint32>)
+                        continue;
+
+                    auto const other = edgecontrolpts(patches[q], f);
+                    bool same = true, reversed = true;
+                    for (uint i(0); i <= d; ++i)
+                    {
+                        same = same && vector3::Distance(edge[i], other[i]) <= tolerance;
+                        reversed = reversed && vector3::Distance(edge[i], other[d - i]) <= tolerance;
+                    }
+
+                    if (same || reversed)
+                    {
+                        r[p][e] = { q, f, !same };
+                        r[q][f] = { p, e, !same };
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    return r;
+}
+
+// tessellates a set of quad patches into one mesh with the same tolerance as a single patch
+// along an edge shared with a neighbour, each patch also gets the leaf corners of the neighbour's side
+// both sides are stitched with the union of the points, so shared edges are split the same way and their vertices are shared
+// edges without a neighbour and corners where patches meet only diagonally are not matched
+template<uint d>
+requires (d >= 1)
+trimesh<patchuv> tessellateadaptive(std::span<planarbezier<2, d> const> patches, std::span<patchadjacency const> adjacency, float tolerance, uint maxdepth = 10)
+{
+    using coord_t = stdx::grididx<1>;
+
+    // coordinates go in 21 bits of the vertex keys below
+    maxdepth = std::min(maxdepth, uint(20));
+    uint const side = 1u << maxdepth;
+
+    std::vector<std::vector<dyadicleaf>> leaves(patches.size());
+    stdx::parallel_for(stdx::range(patches.size()), [&](uint p)
+    {
+        subdivide(patches[p], coord_t(0u, 0u), coord_t(side, side), tolerance, maxdepth, leaves[p]);
+    }, 1);
+
+    // position along an edge and back
+    auto const onedge = [side](coord_t const& c, uint32 edge)
+    {
+        return (edge == 0 && c[1] == 0) || (edge == 1 && c[0] == side) || (edge == 2 && c[1] == side) || (edge == 3 && c[0] == 0);
+    };
+
+    auto const edgecoord = [side](uint32 edge, uint t) { return edge == 0 ? coord_t(t, 0u) : edge == 1 ? coord_t(side, t) : edge == 2 ? coord_t(t, side) : coord_t(0u, t); };
+    auto const across = [side, &edgecoord](coord_t const& c, edgeneighbour const& n, uint32 edge)
+    {
+        uint const t = edge == 0 || edge == 2 ? c[0] : c[1];
+        return edgecoord(n.edge, n.reversed ? side - t : t);
+    };
+
+    std::vector<bakedbezier<2, d>> baked;
+    baked.reserve(patches.size());
+    for (auto const& patch : patches)
+        baked.emplace_back(patch);
+
+    trimesh<patchuv> r;
+    auto const addvertex = [&r, &baked, side](uint32 p, float u, float v)
+    {
+        float const scale = 1.f / float(side);
+        auto const e = baked[p].eval({ u * scale, v * scale });
+        r.params.push_back({ p, stdx::vec2{ u * scale, v * scale } });
+        r.positions.push_back(e[0]);
+        r.normals.push_back(e[1].Cross(e[2]).Normalized());
+        return static_cast<uint32>(r.positions.size() - 1);
+    };
+
+    // a point on shared edges is evaluated on the first patch that reaches it, every patch around it maps to that vertex
+    auto const key = [](uint32 p, coord_t const& c) { return (uint64(p) << 42) | (uint64(c[0]) << 21) | uint64(c[1]); };
+    stdx::flathashmap<uint64, uint32> shared;
+    std::vector<std::pair<uint32, coord_t>> aliases;
+    auto const corner = [&](uint32 p, coord_t const& c)
+    {
+        if (auto const it = shared.find(key(p, c)); it != shared.end())
+            return it->second;
+
+        uint32 const vertex = addvertex(p, float(c[0]), float(c[1]));
+        aliases.assign(1, { p, c });
+        while (!aliases.empty())
+        {
+            auto const [q, qc] = aliases.back();
+            aliases.pop_back();
+            if (!shared.try_emplace(key(q, qc), vertex).second)
+                continue;
+
+            for (uint32 e(0); e < 4; ++e)
+                if (auto const& n = adjacency[q][e]; n.patch != stdx::invalid<uint32> && onedge(qc, e))
+                    aliases.push_back({ n.patch, across(qc, n, e) });
+        }
+
+        return vertex;
+    };
+
+    std::vector<coord_t> boundary;
+    for (uint32 p(0); p < patches.size(); ++p)
+    {
+        boundary.clear();
+        for (uint32 e(0); e < 4; ++e)
+        {
+            auto const& n = adjacency[p][e];
+            if (n.patch == stdx::invalid<uint32>)
+                continue;
+
+            // the neighbour's corners seen from this patch, reversing twice maps its edge back onto ours
+            edgeneighbour const back{ p, e, n.reversed };
+            for (auto const& leaf : leaves[n.patch])
+                for (uint i(0); i < leaf.numcorners; ++i)
+                    if (onedge(leaf.corners[i], n.edge))
+                        boundary.push_back(across(leaf.corners[i], back, n.edge));
+        }
+
+        stitch(leaves[p], boundary, [&](coord_t const& c) { return corner(p, c); }, [&](float u, float v) { return addvertex(p, u, v); }, r.indices);
+    }
+
+    return r;
+}
+
+bool firstclosest(vector3 p, vector3 p0, vector3 p1)
+{
+    return vector3::DistanceSquared(p, p0) < vector3::DistanceSquared(p, p1);
+}
+
+// closest point on a set of curves, curve is the index in the set
+struct curvepoint
+{
+    uint curve;
+    float t;
+    vector3 position;
+};
+
+// power basis around t = 1/2 of a curve and its first two derivatives, for newton on the distance
+template<uint d>
+requires (d >= 1)
+struct curvepolynomials
+{
+    explicit curvepolynomials(planarbezier<1, d> const& c) : value(c.controlnet)
+    {
+        topowerbasis<d>(value.data());
+        for (uint i(0); i < d; ++i)
+            first[i] = value[i + 1] * float(i + 1);
+        for (uint i(0); i + 1 < d; ++i)
+            second[i] = value[i + 2] * float((i + 1) * (i + 2));
+    }
+
+    static constexpr uint newtonsteps = 4;
+
+    // (c(t) - q) . c'(t) has degree 2d - 1 and newton from the middle of a segment only finds one of its roots
+    // so segments get shorter as the degree grows, 8 segments miss minima by 1e-4 on cubics and 3e-3 on quintics
+    static constexpr uint defaultdepth = std::bit_width(2 * d - 1) + 1;
+
+    std::array<controlpoint, d + 1> value;
+    std::array<controlpoint, d> first;
+    std::array<controlpoint, d - 1> second;
+};
+
+// closest points on a set of curves for batches of query points
+// curves are cut into 2^depth segments with de casteljau splits, more for higher degrees by default, the control points of a segment bound it in a box
+// segment ends give every query an upper bound, and newton only runs in segments whose box can beat it
+// queries run stdx::simd::f32pack::width at a time, one per lane
+template<uint d>
+requires (d >= 1)
+struct closestpointquery
+{
+    using curve_t = planarbezier<1, d>;
+
+    closestpointquery(std::span<curve_t const> curves, uint depth = curvepolynomials<d>::defaultdepth)
+    {
+        for (uint c(0); c < curves.size(); ++c)
+        {
+            polys.emplace_back(curves[c]);
+            addsegments(curves[c], c, 0.f, 1.f, depth);
+        }
+    }
+
+    void query(std::span<vector3 const> points, std::span<curvepoint> r, uint grain = 0) const
+    {
+        stdx::cassert(r.size() >= points.size());
+        uint const numpacks = (points.size() + pack_t::width - 1) / pack_t::width;
+        stdx::parallel_for(stdx::range(numpacks), [this, points, r](uint i)
+        {
+            uint const b = i * pack_t::width;
+            querypack(points.subspan(b, std::min(pack_t::width, points.size() - b)), r.subspan(b));
+        }, grain);
+    }
+
+    std::vector<curvepoint> query(std::span<vector3 const> points) const
+    {
+        std::vector<curvepoint> r(points.size());
+        query(points, r);
+        return r;
+    }
+
+private:
+    using pack_t = stdx::simd::f32pack;
+    using packpoint_t = std::array<pack_t, 3>;
+
+    struct segment
+    {
+        vector3 boxmin, boxmax;
+        vector3 start, end;
+        float t0, t1;
+        uint curve;
+    };
+
+    void addsegments(curve_t const& c, uint curve, float t0, float t1, uint depth)
+    {
+        if (depth > 0)
+        {
+            auto const [left, right] = split(c, 0, 0.5f);
+            float const mid = (t0 + t1) * 0.5f;
+            addsegments(left, curve, t0, mid, depth - 1);
+            addsegments(right, curve, mid, t1, depth - 1);
+            return;
+        }
+
+        segment s{ c[0], c[0], c[0], c[d], t0, t1, curve };
+        for (auto const& p : c.controlnet)
+        {
+            s.boxmin = vector3::Min(s.boxmin, p);
+            s.boxmax = vector3::Max(s.boxmax, p);
+        }
+
+        segments.push_back(s);
+    }
+
+    static packpoint_t broadcast(vector3 const& v) { return { pack_t::set1(v.x), pack_t::set1(v.y), pack_t::set1(v.z) }; }
+
+    static pack_t dot(packpoint_t const& a, packpoint_t const& b) { return pack_t::fmadd(a[0], b[0], pack_t::fmadd(a[1], b[1], a[2] * b[2])); }
+
+    static packpoint_t sub(packpoint_t const& a, packpoint_t const& b) { return { a[0] - b[0], a[1] - b[1], a[2] - b[2] }; }
+
+    template<uint m>
+    static std::array<packpoint_t, m> broadcast(std::array<controlpoint, m> const& coeffs)
+    {
+        std::array<packpoint_t, m> r;
+        for (uint i(0); i < m; ++i)
+            r[i] = broadcast(coeffs[i]);
+        return r;
+    }
+
+    void querypack(std::span<vector3 const> points, std::span<curvepoint> r) const
+    {
+        // transposed to structure of arrays, unused lanes repeat the first point
+        std::array<std::array<float, pack_t::width>, 3> q;
+        for (uint l(0); l < pack_t::width; ++l)
+        {
+            auto const& p = points[l < points.size() ? l : 0];
+            q[0][l] = p.x;
+            q[1][l] = p.y;
+            q[2][l] = p.z;
+        }
+
+        packpoint_t const qp{ pack_t::load(q[0].data()), pack_t::load(q[1].data()), pack_t::load(q[2].data()) };
+
+        pack_t best = pack_t::set1(std::numeric_limits<float>::max());
+        pack_t bestt = pack_t::set1(0.f), bestcurve = pack_t::set1(0.f);
+        packpoint_t bestpos = qp;
+        auto const keep = [&](pack_t const& dist2, pack_t const& t, pack_t const& curve, packpoint_t const& pos)
+        {
+            auto const m = pack_t::less(dist2, best);
+            best = pack_t::select(m, dist2, best);
+            bestt = pack_t::select(m, t, bestt);
+            bestcurve = pack_t::select(m, curve, bestcurve);
+            for (uint k(0); k < 3; ++k)
+                bestpos[k] = pack_t::select(m, pos[k], bestpos[k]);
+        };
+
+        // segment ends are points on the curves, so the nearest one bounds the answer
+        for (auto const& s : segments)
+        {
+            auto const curve = pack_t::set1(float(s.curve));
+            auto const start = broadcast(s.start), end = broadcast(s.end);
+            keep(dot(sub(start, qp), sub(start, qp)), pack_t::set1(s.t0), curve, start);
+            keep(dot(sub(end, qp), sub(end, qp)), pack_t::set1(s.t1), curve, end);
+        }
+
+        auto const zero = pack_t::set1(0.f);
+        for (auto const& s : segments)
+        {
+            // distance to the box, no point of the segment is closer
+            pack_t lower = zero;
+            for (uint k(0); k < 3; ++k)
+            {
+                auto const lo = pack_t::set1((&s.boxmin.x)[k]), hi = pack_t::set1((&s.boxmax.x)[k]);
+                auto const out = pack_t::max(pack_t::max(lo - qp[k], qp[k] - hi), zero);
+                lower = pack_t::fmadd(out, out, lower);
+            }
+
+            if (!pack_t::any(pack_t::less(lower, best)))
+                continue;
+
+            auto const& poly = polys[s.curve];
+            auto const value = broadcast(poly.value);
+            auto const first = broadcast(poly.first);
+            auto const t0 = pack_t::set1(s.t0), t1 = pack_t::set1(s.t1), half = pack_t::set1(0.5f);
+
+            // newton on (c(t) - q) . c'(t) = 0 from the middle of the segment, kept inside it
+            pack_t t = pack_t::set1((s.t0 + s.t1) * 0.5f);
+            for (uint i(0); i < curvepolynomials<d>::newtonsteps; ++i)
+            {
+                auto const st = t - half;
+                auto const diff = sub(hornervalue<d>(value.data(), st), qp);
+                auto const dc = hornervalue<d - 1>(first.data(), st);
+
+                pack_t slope = dot(dc, dc);
+                if constexpr (d >= 2)
+                {
+                    auto const second = broadcast(poly.second);
+                    slope = slope + dot(diff, hornervalue<d - 2>(second.data(), st));
+                }
+
+                // a non positive slope means t isn't near a minimum yet, that lane stays put
+                auto const step = dot(diff, dc) / slope;
+                t = pack_t::select(pack_t::less(zero, slope), t - step, t);
+                t = pack_t::min(pack_t::max(t, t0), t1);
+            }
+
+            auto const pos = hornervalue<d>(value.data(), t - half);
+            auto const diff = sub(pos, qp);
+            keep(dot(diff, diff), t, pack_t::set1(float(s.curve)), pos);
+        }
+
+        std::array<std::array<float, pack_t::width>, 5> out;
+        bestt.store(out[0].data());
+        bestcurve.store(out[1].data());
+        for (uint k(0); k < 3; ++k)
+            bestpos[k].store(out[k + 2].data());
+
+        for (uint l(0); l < points.size(); ++l)
+            r[l] = { static_cast<uint>(out[1][l]), out[0][l], vector3(out[2][l], out[3][l], out[4][l]) };
+    }
+
+    std::vector<curvepolynomials<d>> polys;
+    std::vector<segment> segments;
+};
+
+using paramandpoint = std::pair<float, vector3>;
+
+// a single query in scalar code, the same newton as closestpointquery from the middle of 2^depth uniform segments
+// there are no segment boxes to skip with, building them costs more than the segments they would skip
+template<uint d>
+requires (d >= 1)
+paramandpoint closestpoint(planarbezier<1, d> const& c, vector3 p, uint depth = curvepolynomials<d>::defaultdepth)
+{
+    curvepolynomials<d> const poly(c);
+
+    paramandpoint best{ 0.f, c[0] };
+    float bestdist = vector3::DistanceSquared(c[0], p);
+    auto const keep = [&](float t, vector3 const& pos)
+    {
+        if (float const dist = vector3::DistanceSquared(pos, p); dist < bestdist)
+        {
+            bestdist = dist;
+            best = { t, pos };
+        }
+    };
+
+    keep(1.f, c[d]);
+    uint const numsegments = 1u << depth;
+    for (uint i(0); i < numsegments; ++i)
+    {
+        float const t0 = float(i) / numsegments, t1 = float(i + 1) / numsegments;
+        if (i + 1 < numsegments)
+            keep(t1, hornervalue<d>(poly.value.data(), t1 - 0.5f));
+
+        float t = (t0 + t1) * 0.5f;
+        for (uint step(0); step < curvepolynomials<d>::newtonsteps; ++step)
+        {
+            float const st = t - 0.5f;
+            vector3 const diff = hornervalue<d>(poly.value.data(), st) - p;
+            vector3 const dc = hornervalue<d - 1>(poly.first.data(), st);
+
+            float slope = dc.Dot(dc);
+            if constexpr (d >= 2)
+                slope += diff.Dot(hornervalue<d - 2>(poly.second.data(), st));
+
+            if (slope > 0.f)
+                t = std::clamp(t - diff.Dot(dc) / slope, t0, t1);
+        }
+
+        keep(t, hornervalue<d>(poly.value.data(), t - 0.5f));
+    }
+
+    return best;
 }
 
 }
\ No newline at end of file
@@ -10,6 +10,7 @@ module;
 module engine;
 
 import activesample;
+import memory;
 import std;
 
 using Microsoft::WRL::ComPtr;
@@ -40,6 +41,9 @@ continuity::continuity()
     , m_height(1440)
     , m_frameCounter(0)
 {
+    // count pmr allocations that fall through to the default resource, all other heap allocations are counted by heapcounter
+    std::pmr::set_default_resource(&stdx::countingresource::get());
+
     view_data vdata;
     vdata.width = m_width;
     vdata.height = m_height;
@@ -61,11 +65,22 @@ void continuity::OnUpdate()
 {
     m_timer.Tick(NULL);
 
-    if (m_frameCounter++ % 30 == 0)
+    // transient data of the last frame is released all at once
+    stdx::framearena::get().reset();
+
+    static constexpr uint titleupdateframes = 30;
+    if (m_frameCounter++ % titleupdateframes == 0)
     {
-        // update window text with FPS value.
-        wchar_t fps[64];
-        swprintf_s(fps, L"%ufps", m_timer.GetFramesPerSecond());
+        auto& heapallocs = stdx::heapcounter::get();
+        auto& pmrallocs = stdx::countingresource::get();
+        auto const heapperframe = heapallocs.allocations() / titleupdateframes;
+        auto const pmrperframe = pmrallocs.allocations() / titleupdateframes;
+        heapallocs.resetcounts();
+        pmrallocs.resetcounts();
+
+        // update window text with FPS value and allocations.
+        wchar_t fps[96];
+        swprintf_s(fps, L"%ufps, %zu heap allocs/frame, %zu of them pmr", m_timer.GetFramesPerSecond(), heapperframe, pmrperframe);
 
         std::wstring title = sample_titles[int(activesample)];
         if (title.empty())
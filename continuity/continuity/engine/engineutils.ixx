@@ -16,17 +16,11 @@ export using Microsoft::WRL::ComPtr;
 export namespace utils
 {
 
-// helper function until matrix4x4 is better implemented 
-stdx::matrix4x4 to_matrix4x4(DirectX::SimpleMath::Matrix const& matrix)
-{
-    stdx::matrix4x4 r;
-    r[0] = stdx::vec4{ matrix.m[0][0], matrix.m[0][1], matrix.m[0][2], matrix.m[0][3] };
-    r[1] = stdx::vec4{ matrix.m[1][0], matrix.m[1][1], matrix.m[1][2], matrix.m[1][3] };
-    r[2] = stdx::vec4{ matrix.m[2][0], matrix.m[2][1], matrix.m[2][2], matrix.m[2][3] };
-    r[3] = stdx::vec4{ matrix.m[3][0], matrix.m[3][1], matrix.m[3][2], matrix.m[3][3] };
+// both are row major 4x4 floats with the same convention, so conversions are a plain copy
+static_assert(sizeof(stdx::matrix4x4) == sizeof(DirectX::SimpleMath::Matrix));
 
-    return r;
-}
+stdx::matrix4x4 to_matrix4x4(DirectX::SimpleMath::Matrix const& matrix) { return std::bit_cast<stdx::matrix4x4>(matrix); }
+DirectX::SimpleMath::Matrix to_matrix(stdx::matrix4x4 const& matrix) { return std::bit_cast<DirectX::SimpleMath::Matrix>(matrix); }
 
 std::wstring strtowstr(std::string const& str)
 {
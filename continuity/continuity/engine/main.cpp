@@ -3,16 +3,52 @@
 #include <dxgidebug.h>
 #include <wrl.h>
 #include <dxgi1_6.h>
+#include <malloc.h>
 
 import engine;
+import benchmarks;
+import memory;
+import std;
 
 using namespace ABI::Windows::Foundation;
 using namespace Microsoft::WRL;
 using namespace Microsoft::WRL::Wrappers;
 
+// replacing the global allocation functions counts every heap allocation, not only the pmr ones, for the window title
+void* operator new(std::size_t size)
+{
+    stdx::heapcounter::get().add(size);
+    if (void* p = std::malloc(size == 0 ? 1 : size))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    stdx::heapcounter::get().add(size);
+    if (void* p = _aligned_malloc(size == 0 ? 1 : size, std::size_t(alignment)))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { _aligned_free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { _aligned_free(p); }
+
 _Use_decl_annotations_
-int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow)
+int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR lpCmdLine, int nCmdShow)
 {
+    // headless benchmarks, "-bench [filter]" writes the results to benchmarks.txt in the working directory
+    std::string_view cmdline = lpCmdLine;
+    if (cmdline.starts_with("-bench"))
+    {
+        cmdline.remove_prefix(std::min(cmdline.size(), cmdline.find_first_not_of(' ', 6)));
+        std::ofstream log("benchmarks.txt");
+        return int(benchmarks::run(cmdline, log));
+    }
 
 #if (_WIN32_WINNT >= 0x0A00 /*_WIN32_WINNT_WIN10*/)
     RoInitializeWrapper initialize(RO_INIT_MULTITHREADED);
@@ -0,0 +1,205 @@
+module;
+
+#include <immintrin.h>
+
+module geometry:aabbset;
+
+import stdxcore;
+import stdx;
+import vec;
+import jobs;
+import std;
+
+namespace geometry
+{
+
+namespace
+{
+
+static_assert(sizeof(stdx::vec3) == 3 * sizeof(float), "point clouds are read as packed floats");
+
+// 8 packed points are 24 floats, three loads whose lanes always hold the same components
+// lane l of load k holds component (8k + l) % 3, so the running min and max need no shuffles
+aabb reducebounds(stdx::vec3 const* points, uint count)
+{
+    float const* data = points->data();
+    __m256 lo[3], hi[3];
+    for (uint k(0); k < 3; ++k)
+    {
+        lo[k] = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+        hi[k] = _mm256_set1_ps(-std::numeric_limits<float>::infinity());
+    }
+
+    uint i = 0;
+    for (; i + aabbset::width <= count; i += aabbset::width)
+        for (uint k(0); k < 3; ++k)
+        {
+            __m256 const v = _mm256_loadu_ps(data + 3 * i + aabbset::width * k);
+            lo[k] = _mm256_min_ps(lo[k], v);
+            hi[k] = _mm256_max_ps(hi[k], v);
+        }
+
+    aabb res = { stdx::vec3::filled(std::numeric_limits<float>::infinity()), stdx::vec3::filled(-std::numeric_limits<float>::infinity()) };
+    for (uint k(0); k < 3; ++k)
+    {
+        alignas(32) float los[aabbset::width], his[aabbset::width];
+        _mm256_store_ps(los, lo[k]);
+        _mm256_store_ps(his, hi[k]);
+        for (uint l(0); l < aabbset::width; ++l)
+        {
+            uint const a = (aabbset::width * k + l) % 3;
+            res.min_pt[a] = std::min(res.min_pt[a], los[l]);
+            res.max_pt[a] = std::max(res.max_pt[a], his[l]);
+        }
+    }
+
+    for (; i < count; ++i)
+        res += points[i];
+
+    return res;
+}
+
+__m256 load(std::vector<float> const& v, uint block) { return _mm256_loadu_ps(v.data() + block * aabbset::width); }
+
+}
+
+aabb bounds(std::span<stdx::vec3 const> points, uint grain)
+{
+    auto& system = stdx::jobsystem::get();
+    uint const count = points.size();
+
+    // chunks smaller than this reduce faster than a job is handed out
+    constexpr uint mingrain = 1 << 14;
+    if (grain == 0)
+        grain = std::max(mingrain, count / std::max(system.chunkcount(count, 0), uint(1)));
+
+    std::vector<aabb> partials(system.chunkcount(count, grain));
+    system.forchunks(count, grain, [&](uint chunk, uint b, uint e) { partials[chunk] = reducebounds(points.data() + b, e - b); });
+
+    aabb res = { stdx::vec3::filled(std::numeric_limits<float>::infinity()), stdx::vec3::filled(-std::numeric_limits<float>::infinity()) };
+    for (auto const& p : partials)
+        res = { { std::min(res.min_pt[0], p.min_pt[0]), std::min(res.min_pt[1], p.min_pt[1]), std::min(res.min_pt[2], p.min_pt[2]) },
+                { std::max(res.max_pt[0], p.max_pt[0]), std::max(res.max_pt[1], p.max_pt[1]), std::max(res.max_pt[2], p.max_pt[2]) } };
+
+    return res;
+}
+
+aabbset::aabbset(std::span<aabb const> boxes)
+{
+    uint const padded = (boxes.size() + width - 1) / width * width;
+    for (uint a(0); a < 3; ++a)
+    {
+        _min[a].assign(padded, std::numeric_limits<float>::infinity());
+        _max[a].assign(padded, -std::numeric_limits<float>::infinity());
+        for (uint i(0); i < boxes.size(); ++i)
+        {
+            _min[a][i] = boxes[i].min_pt[a];
+            _max[a][i] = boxes[i].max_pt[a];
+        }
+    }
+
+    _size = boxes.size();
+}
+
+aabb aabbset::operator[](uint i) const { return { { _min[0][i], _min[1][i], _min[2][i] }, { _max[0][i], _max[1][i], _max[2][i] } }; }
+
+void aabbset::push_back(aabb const& box)
+{
+    if (_size % width == 0)
+        for (uint a(0); a < 3; ++a)
+        {
+            _min[a].resize(_size + width, std::numeric_limits<float>::infinity());
+            _max[a].resize(_size + width, -std::numeric_limits<float>::infinity());
+        }
+
+    for (uint a(0); a < 3; ++a)
+    {
+        _min[a][_size] = box.min_pt[a];
+        _max[a][_size] = box.max_pt[a];
+    }
+
+    ++_size;
+}
+
+void aabbset::clear()
+{
+    for (uint a(0); a < 3; ++a)
+    {
+        _min[a].clear();
+        _max[a].clear();
+    }
+
+    _size = 0;
+}
+
+void aabbset::contains(stdx::vec3 const& pt, std::span<uint8> masks) const
+{
+    stdx::cassert(masks.size() >= numblocks(), "a mask per block of boxes");
+
+    __m256 const p[3] = { _mm256_set1_ps(pt[0]), _mm256_set1_ps(pt[1]), _mm256_set1_ps(pt[2]) };
+    for (uint b(0); b < numblocks(); ++b)
+    {
+        __m256 in = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (uint a(0); a < 3; ++a)
+        {
+            in = _mm256_and_ps(in, _mm256_cmp_ps(load(_min[a], b), p[a], _CMP_LE_OQ));
+            in = _mm256_and_ps(in, _mm256_cmp_ps(p[a], load(_max[a], b), _CMP_LE_OQ));
+        }
+
+        masks[b] = uint8(_mm256_movemask_ps(in));
+    }
+}
+
+void aabbset::overlaps(aabb const& box, std::span<uint8> masks) const
+{
+    stdx::cassert(masks.size() >= numblocks(), "a mask per block of boxes");
+
+    __m256 const lo[3] = { _mm256_set1_ps(box.min_pt[0]), _mm256_set1_ps(box.min_pt[1]), _mm256_set1_ps(box.min_pt[2]) };
+    __m256 const hi[3] = { _mm256_set1_ps(box.max_pt[0]), _mm256_set1_ps(box.max_pt[1]), _mm256_set1_ps(box.max_pt[2]) };
+    for (uint b(0); b < numblocks(); ++b)
+    {
+        __m256 in = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (uint a(0); a < 3; ++a)
+        {
+            in = _mm256_and_ps(in, _mm256_cmp_ps(load(_min[a], b), hi[a], _CMP_LE_OQ));
+            in = _mm256_and_ps(in, _mm256_cmp_ps(lo[a], load(_max[a], b), _CMP_LE_OQ));
+        }
+
+        masks[b] = uint8(_mm256_movemask_ps(in));
+    }
+}
+
+void aabbset::intersect(ray const& r, std::span<uint8> masks) const
+{
+    stdx::cassert(masks.size() >= numblocks(), "a mask per block of boxes");
+
+    // slabs as t = plane * invdir - origin * invdir
+    auto const invdir = r.invdir();
+    __m256 scale[3], offset[3];
+    for (uint a(0); a < 3; ++a)
+    {
+        scale[a] = _mm256_set1_ps(invdir[a]);
+        offset[a] = _mm256_set1_ps(-r.origin[a] * invdir[a]);
+    }
+
+    __m256 const tmin = _mm256_set1_ps(r.tmin), tmax = _mm256_set1_ps(r.tmax);
+    for (uint b(0); b < numblocks(); ++b)
+    {
+        __m256 tnear = tmin, tfar = tmax;
+        for (uint a(0); a < 3; ++a)
+        {
+            __m256 const t0 = _mm256_fmadd_ps(load(_min[a], b), scale[a], offset[a]);
+            __m256 const t1 = _mm256_fmadd_ps(load(_max[a], b), scale[a], offset[a]);
+            tnear = _mm256_max_ps(tnear, _mm256_min_ps(t0, t1));
+            tfar = _mm256_min_ps(tfar, _mm256_max_ps(t0, t1));
+        }
+
+        masks[b] = uint8(_mm256_movemask_ps(_mm256_cmp_ps(tnear, tfar, _CMP_LE_OQ)));
+    }
+
+    // padding boxes span every slab once min and max swap, so their lanes are cleared here
+    if (uint const tail = _size % width)
+        masks[numblocks() - 1] &= uint8((1u << tail) - 1);
+}
+
+}
@@ -0,0 +1,49 @@
+export module geometry:aabbset;
+
+import stdxcore;
+import stdx;
+import vec;
+import std;
+import :shapes;
+import :bvh;
+
+export namespace geometry
+{
+
+// bounds of a point cloud, 8 points at a time with avx2, large clouds are reduced in chunks over the job system
+// an empty cloud gives an empty box, min above max
+aabb bounds(std::span<stdx::vec3 const> points, uint grain = 0);
+
+// boxes stored as structure of arrays, so a query tests 8 of them at once with avx2
+// queries write a mask per block of 8 boxes, bit i is set for box 8 * block + i, bits past size() are never set
+class aabbset
+{
+public:
+    static constexpr uint width = 8;
+
+    aabbset() = default;
+    explicit aabbset(std::span<aabb const> boxes);
+
+    uint size() const { return _size; }
+    uint numblocks() const { return (_size + width - 1) / width; }
+
+    aabb operator[](uint i) const;
+    void push_back(aabb const& box);
+    void clear();
+
+    // boxes containing the point, boundaries included
+    void contains(stdx::vec3 const& pt, std::span<uint8> masks) const;
+
+    // boxes overlapping the box, touching ones included
+    void overlaps(aabb const& box, std::span<uint8> masks) const;
+
+    // boxes the ray passes through within [tmin, tmax]
+    void intersect(ray const& r, std::span<uint8> masks) const;
+
+private:
+    // padded to whole blocks with empty boxes
+    std::array<std::vector<float>, 3> _min, _max;
+    uint _size = 0;
+};
+
+}
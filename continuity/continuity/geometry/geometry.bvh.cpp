@@ -0,0 +1,980 @@
+module;
+
+#include <immintrin.h>
+
+module geometry:bvh;
+
+import stdxcore;
+import stdx;
+import vec;
+import jobs;
+import std;
+
+namespace geometry
+{
+
+namespace
+{
+
+constexpr uint numbins = 16;
+
+// nodes with more primitives than this bin in parallel and build their children as separate jobs
+constexpr uint parallelcount = 1 << 14;
+
+aabb emptybox() { return { stdx::vec3::filled(std::numeric_limits<float>::max()), stdx::vec3::filled(std::numeric_limits<float>::lowest()) }; }
+
+// aabb::operator+= lives in another translation unit, the builder merges boxes often enough to want this inlined
+aabb merge(aabb const& l, aabb const& r)
+{
+    auto const& lmin = l.min_pt, & lmax = l.max_pt, & rmin = r.min_pt, & rmax = r.max_pt;
+    return { { std::min(lmin[0], rmin[0]), std::min(lmin[1], rmin[1]), std::min(lmin[2], rmin[2]) }, { std::max(lmax[0], rmax[0]), std::max(lmax[1], rmax[1]), std::max(lmax[2], rmax[2]) } };
+}
+
+float halfarea(aabb const& box)
+{
+    auto const s = box.span();
+    return s[0] * s[1] + s[1] * s[2] + s[2] * s[0];
+}
+
+struct bin
+{
+    aabb bounds = emptybox();
+    uint count = 0;
+};
+
+// bounds of a node's primitives and of their centroids
+struct extents
+{
+    extents merge(extents const& r) const { return { geometry::merge(bounds, r.bounds), geometry::merge(centroids, r.centroids) }; }
+
+    aabb bounds = emptybox();
+    aabb centroids = emptybox();
+};
+
+struct binning
+{
+    binning merge(binning const& r) const
+    {
+        binning res;
+        for (uint a(0); a < 3; ++a)
+            for (uint b(0); b < numbins; ++b)
+                res.bins[a][b] = { geometry::merge(bins[a][b].bounds, r.bins[a][b].bounds), bins[a][b].count + r.bins[a][b].count };
+
+        return res;
+    }
+
+    std::array<std::array<bin, numbins>, 3> bins;
+};
+
+struct sahbuilder
+{
+    void build(uint32 nodeidx, uint32 first, uint32 count, uint depth)
+    {
+        // bounds of the node and of the centroids set up the bins
+        auto const ext = accumulate<extents>(first, count, [&](extents& e, uint32 prim)
+        {
+            e.bounds = geometry::merge(e.bounds, boxes[prim]);
+            e.centroids = geometry::merge(e.centroids, { centroids[prim], centroids[prim] });
+        });
+
+        auto& node = nodes[nodeidx];
+        node.bounds = ext.bounds;
+
+        auto const makeleaf = [&]()
+        {
+            node.first = first;
+            node.count = count;
+        };
+
+        if (count <= 1)
+            return makeleaf();
+
+        auto const cmin = ext.centroids.min_pt;
+        auto const cspan = ext.centroids.span();
+
+        uint axis = 0, splitbin = 0;
+        float bestcost = std::numeric_limits<float>::max();
+        if (depth < bvh::maxdepth / 2)
+        {
+            // small nodes don't need all the bins
+            uint const nbins = std::min(numbins, uint(count));
+            auto const binof = [&](uint32 prim, uint a) { return std::min(nbins - 1, uint((centroids[prim][a] - cmin[a]) * (nbins / cspan[a]))); };
+            auto const binned = accumulate<binning>(first, count, [&](binning& b, uint32 prim)
+            {
+                for (uint a(0); a < 3; ++a)
+                {
+                    if (cspan[a] <= 0.f)
+                        continue;
+
+                    auto& bn = b.bins[a][binof(prim, a)];
+                    bn.bounds = geometry::merge(bn.bounds, boxes[prim]);
+                    ++bn.count;
+                }
+            });
+
+            // sweep the bins from the right to get the cost of every right side, then from the left
+            for (uint a(0); a < 3; ++a)
+            {
+                if (cspan[a] <= 0.f)
+                    continue;
+
+                auto const& bins = binned.bins[a];
+                std::array<float, numbins> rightcost;
+                aabb acc = emptybox();
+                uint account = 0;
+                for (uint b(nbins - 1); b > 0; --b)
+                {
+                    if (bins[b].count > 0)
+                    {
+                        acc = geometry::merge(acc, bins[b].bounds);
+                        account += bins[b].count;
+                    }
+
+                    rightcost[b - 1] = account > 0 ? halfarea(acc) * account : 0.f;
+                }
+
+                acc = emptybox();
+                account = 0;
+                for (uint b(0); b < nbins - 1; ++b)
+                {
+                    if (bins[b].count == 0)
+                        continue;
+
+                    acc = geometry::merge(acc, bins[b].bounds);
+                    account += bins[b].count;
+                    if (account == count)
+                        continue;
+
+                    float const cost = halfarea(acc) * account + rightcost[b];
+                    if (cost < bestcost)
+                    {
+                        bestcost = cost;
+                        axis = a;
+                        splitbin = b;
+                    }
+                }
+            }
+
+            // a split costs a traversal step plus the children weighted by their chance of being hit
+            bool const found = bestcost != std::numeric_limits<float>::max();
+            float const leafcost = float(count);
+            float const splitcost = 1.f + bestcost / halfarea(node.bounds);
+            if (count <= maxleafsize && (!found || splitcost >= leafcost))
+                return makeleaf();
+
+            if (found)
+            {
+                auto const begin = primitives.begin() + first;
+                auto const mid = std::partition(begin, begin + count, [&](uint32 prim) { return binof(prim, axis) <= splitbin; });
+                return split(node, first, count, uint32(mid - begin), depth);
+            }
+        }
+
+        if (count <= maxleafsize)
+            return makeleaf();
+
+        // coincident centroids or a deep tree, split at the median of the widest axis
+        axis = cspan[0] >= cspan[1] && cspan[0] >= cspan[2] ? 0 : (cspan[1] >= cspan[2] ? 1 : 2);
+        auto const begin = primitives.begin() + first;
+        std::nth_element(begin, begin + count / 2, begin + count, [&](uint32 l, uint32 r) { return centroids[l][axis] < centroids[r][axis]; });
+        split(node, first, count, count / 2, depth);
+    }
+
+    void split(bvhnode& node, uint32 first, uint32 count, uint32 leftcount, uint depth)
+    {
+        uint32 const children = numnodes.fetch_add(2, std::memory_order_relaxed);
+        node.first = children;
+        node.count = 0;
+
+        if (count > parallelcount)
+        {
+            stdx::jobgroup group;
+            stdx::jobsystem::get().submit(group, [=, this]() { build(children, first, leftcount, depth + 1); });
+            build(children + 1, first + leftcount, count - leftcount, depth + 1);
+            stdx::jobsystem::get().wait(group);
+        }
+        else
+        {
+            build(children, first, leftcount, depth + 1);
+            build(children + 1, first + leftcount, count - leftcount, depth + 1);
+        }
+    }
+
+    // adds the node's primitives to an accumulator, per chunk for large nodes
+    template<typename acc_t, typename add_t>
+    acc_t accumulate(uint32 first, uint32 count, add_t const& add) const
+    {
+        acc_t res;
+        if (count <= parallelcount)
+        {
+            for (uint32 i(first); i < first + count; ++i)
+                add(res, primitives[i]);
+
+            return res;
+        }
+
+        auto& system = stdx::jobsystem::get();
+        std::vector<acc_t> partials(system.chunkcount(count, 0));
+        system.forchunks(count, 0, [&](uint chunk, uint b, uint e)
+        {
+            for (uint i(b); i < e; ++i)
+                add(partials[chunk], primitives[first + i]);
+        });
+
+        for (auto const& p : partials)
+            res = res.merge(p);
+
+        return res;
+    }
+
+    std::span<aabb const> boxes;
+    std::vector<stdx::vec3> centroids;
+    std::vector<bvhnode>& nodes;
+    std::vector<uint32>& primitives;
+    std::atomic<uint32> numnodes = 1;
+    uint maxleafsize;
+};
+
+}
+
+bvh::bvh(std::span<aabb const> boxes, uint maxleafsize)
+{
+    if (boxes.empty())
+        return;
+
+    // a binary tree with a primitive per leaf has 2n - 1 nodes, so building never reallocates under the jobs
+    _nodes.resize(boxes.size() * 2 - 1);
+    _primitives.resize(boxes.size());
+    std::iota(_primitives.begin(), _primitives.end(), uint32(0));
+
+    sahbuilder builder{ boxes, std::vector<stdx::vec3>(boxes.size()), _nodes, _primitives };
+    builder.maxleafsize = std::max(maxleafsize, uint(1));
+    stdx::parallel_for(stdx::range(boxes.size()), [&](uint i) { builder.centroids[i] = boxes[i].center(); });
+
+    builder.build(0, 0, uint32(boxes.size()), 0);
+    _nodes.resize(builder.numnodes.load());
+    _maxleafsize = builder.maxleafsize;
+    _builtcost = sahcost();
+}
+
+namespace
+{
+
+// stable lsd radix sort of keys and their values, 8 bits per pass
+// chunks count their digits and later scatter them in parallel, the offsets are laid out digit major so each chunk keeps its order
+void radixsort(std::vector<uint64>& keys, std::vector<uint32>& values, uint keybits)
+{
+    auto& system = stdx::jobsystem::get();
+    uint const count = keys.size();
+    std::vector<uint64> sortedkeys(count);
+    std::vector<uint32> sortedvalues(count);
+    std::vector<std::array<uint32, 256>> offsets(system.chunkcount(count, 0));
+    for (uint shift(0); shift < keybits; shift += 8)
+    {
+        system.forchunks(count, 0, [&](uint chunk, uint b, uint e)
+        {
+            auto& histogram = offsets[chunk];
+            histogram.fill(0);
+            for (uint i(b); i < e; ++i)
+                ++histogram[(keys[i] >> shift) & 255];
+        });
+
+        // nothing moves when every key has the same digit
+        uint32 sum = 0;
+        bool sorted = false;
+        for (uint d(0); d < 256; ++d)
+        {
+            uint32 const start = sum;
+            for (auto& histogram : offsets)
+                sum += std::exchange(histogram[d], sum);
+
+            sorted = sorted || (sum - start == count);
+        }
+
+        if (sorted)
+            continue;
+
+        system.forchunks(count, 0, [&](uint chunk, uint b, uint e)
+        {
+            auto& offset = offsets[chunk];
+            for (uint i(b); i < e; ++i)
+            {
+                uint32 const dst = offset[(keys[i] >> shift) & 255]++;
+                sortedkeys[dst] = keys[i];
+                sortedvalues[dst] = values[i];
+            }
+        });
+
+        keys.swap(sortedkeys);
+        values.swap(sortedvalues);
+    }
+}
+
+}
+
+// karras, maximizing parallelism in the construction of bvhs, octrees and k-d trees
+// the children of internal node i go to slots 1 + 2i and 2 + 2i, so siblings are adjacent without a relayout
+bvh bvh::linear(std::span<aabb const> boxes, uint coordbits)
+{
+    stdx::cassert(coordbits > 0 && coordbits <= stdx::mortonidx<2>::coordbits, "morton codes have at most 21 bits per axis");
+
+    bvh res;
+    uint const count = boxes.size();
+    if (count == 0)
+        return res;
+
+    auto const centroids = stdx::parallel_reduce(stdx::range(count), emptybox(), [&](uint i) { auto const c = boxes[i].center(); return aabb(c, c); }, merge);
+    auto const cmin = centroids.min_pt, cspan = centroids.span();
+
+    // centroids to grid cells, flat axes all land in cell 0
+    uint const maxcell = (uint(1) << coordbits) - 1;
+    std::array<float, 3> scale;
+    for (uint a(0); a < 3; ++a)
+        scale[a] = cspan[a] > 0.f ? float(maxcell + 1) / cspan[a] : 0.f;
+
+    std::vector<uint64> codes(count);
+    res._primitives.resize(count);
+    stdx::parallel_for(stdx::range(count), [&](uint i)
+    {
+        auto const c = boxes[i].center();
+        std::array<uint, 3> q;
+        for (uint a(0); a < 3; ++a)
+            q[a] = std::min(uint((c[a] - cmin[a]) * scale[a]), maxcell);
+
+        codes[i] = stdx::mortonidx<2>::encode(stdx::grididx<2>(q[0], q[1], q[2]));
+        res._primitives[i] = uint32(i);
+    });
+
+    radixsort(codes, res._primitives, coordbits * 3);
+
+    res._coordbits = coordbits;
+    res._nodes.resize(count * 2 - 1);
+    if (count == 1)
+    {
+        res._nodes[0] = { boxes[0], 0, 1 };
+        res._builtcost = res.sahcost();
+        return res;
+    }
+
+    // length of the common prefix of two sorted codes, equal codes are told apart by their position
+    auto const delta = [&](uint i, std::int64_t j) -> int
+    {
+        if (j < 0 || j >= std::int64_t(count))
+            return -1;
+
+        uint64 const diff = codes[i] ^ codes[j];
+        return diff != 0 ? std::countl_zero(diff) : 64 + std::countl_zero(uint32(i ^ uint(j)));
+    };
+
+    // slots of the internal nodes and leaves, and the number of children whose bounds are done for each internal node
+    std::vector<uint32> internalslots(count - 1), leafslots(count);
+    std::vector<std::atomic<uint32>> visits(count - 1);
+    res._nodes[0] = { {}, 1, 0 };
+    internalslots[0] = 0;
+
+    stdx::parallel_for(stdx::range(count - 1), [&](uint i)
+    {
+        // direction of the range and an upper bound of its length
+        std::int64_t const d = delta(i, std::int64_t(i) + 1) > delta(i, std::int64_t(i) - 1) ? 1 : -1;
+        int const deltamin = delta(i, std::int64_t(i) - d);
+        std::int64_t maxlen = 2;
+        while (delta(i, std::int64_t(i) + maxlen * d) > deltamin)
+            maxlen *= 2;
+
+        // binary search for the other end of the range, then for the split
+        std::int64_t len = 0;
+        for (std::int64_t t(maxlen / 2); t >= 1; t /= 2)
+            if (delta(i, std::int64_t(i) + (len + t) * d) > deltamin)
+                len += t;
+
+        std::int64_t const j = std::int64_t(i) + len * d;
+        int const deltanode = delta(i, j);
+        std::int64_t split = 0;
+        std::int64_t t = len;
+        do
+        {
+            t = (t + 1) / 2;
+            if (delta(i, std::int64_t(i) + (split + t) * d) > deltanode)
+                split += t;
+        } while (t > 1);
+
+        std::int64_t const gamma = std::int64_t(i) + split * d + std::min<std::int64_t>(d, 0);
+
+        // a child covering a single position is a leaf
+        for (uint side(0); side < 2; ++side)
+        {
+            uint32 const slot = uint32(1 + 2 * i + side);
+            uint32 const child = uint32(gamma + side);
+            bool const leaf = side == 0 ? std::min(std::int64_t(i), j) == gamma : std::max(std::int64_t(i), j) == gamma + 1;
+            if (leaf)
+            {
+                res._nodes[slot] = { {}, child, 1 };
+                leafslots[child] = slot;
+            }
+            else
+            {
+                res._nodes[slot] = { {}, 1 + 2 * child, 0 };
+                internalslots[child] = slot;
+            }
+        }
+    });
+
+    // bounds bottom up, the second child to finish carries on with the parent
+    stdx::parallel_for(stdx::range(count), [&](uint k)
+    {
+        uint32 slot = leafslots[k];
+        res._nodes[slot].bounds = boxes[res._primitives[k]];
+        while (slot != 0)
+        {
+            uint32 const parent = (slot - 1) / 2;
+            if (visits[parent].fetch_add(1, std::memory_order_acq_rel) == 0)
+                return;
+
+            slot = internalslots[parent];
+            res._nodes[slot].bounds = merge(res._nodes[1 + 2 * parent].bounds, res._nodes[2 + 2 * parent].bounds);
+        }
+    });
+
+    res._builtcost = res.sahcost();
+    return res;
+}
+
+float bvh::sahcost() const
+{
+    if (_nodes.empty())
+        return 0.f;
+
+    // flat roots have no area to weigh the nodes by
+    float const rootarea = halfarea(_nodes[0].bounds);
+    if (rootarea <= 0.f)
+        return 0.f;
+
+    auto const cost = [this](uint i) { return halfarea(_nodes[i].bounds) * (_nodes[i].leaf() ? float(_nodes[i].count) : 1.f); };
+    return stdx::parallel_reduce(stdx::range(_nodes.size()), 0.f, cost, std::plus<float>{}) / rootarea;
+}
+
+// every leaf walks up like in the linear build and stops at a node whose other child isn't done yet
+float bvh::refit(std::span<aabb const> boxes)
+{
+    stdx::cassert(boxes.size() == _primitives.size(), "a refit needs the boxes the tree was built from");
+    if (_nodes.empty())
+        return 1.f;
+
+    if (_parents.size() != _nodes.size())
+    {
+        _parents.resize(_nodes.size());
+        stdx::parallel_for(stdx::range(_nodes.size()), [this](uint i)
+        {
+            if (!_nodes[i].leaf())
+                _parents[_nodes[i].first] = _parents[_nodes[i].first + 1] = uint32(i);
+        });
+    }
+
+    std::vector<std::atomic<uint32>> visits(_nodes.size());
+    stdx::parallel_for(stdx::range(_nodes.size()), [&](uint i)
+    {
+        auto& leaf = _nodes[i];
+        if (!leaf.leaf())
+            return;
+
+        aabb bounds = boxes[_primitives[leaf.first]];
+        for (uint32 p(leaf.first + 1); p < leaf.first + leaf.count; ++p)
+            bounds = merge(bounds, boxes[_primitives[p]]);
+
+        leaf.bounds = bounds;
+        for (uint32 node = uint32(i); node != 0;)
+        {
+            node = _parents[node];
+            if (visits[node].fetch_add(1, std::memory_order_acq_rel) == 0)
+                return;
+
+            auto& n = _nodes[node];
+            n.bounds = merge(_nodes[n.first].bounds, _nodes[n.first + 1].bounds);
+        }
+    });
+
+    float const cost = sahcost();
+    if (_builtcost <= 0.f)
+        _lastgrowth = cost > 0.f ? std::numeric_limits<float>::infinity() : 1.f;
+    else
+        _lastgrowth = cost / _builtcost;
+
+    return _lastgrowth;
+}
+
+bool bvh::update(std::span<aabb const> boxes, float maxgrowth)
+{
+    float const growth = refit(boxes);
+    if (growth <= maxgrowth)
+        return false;
+
+    *this = _coordbits > 0 ? linear(boxes, _coordbits) : bvh(boxes, _maxleafsize);
+    _lastgrowth = growth;
+    return true;
+}
+
+float bvh::intersect(aabb const& box, stdx::vec3 const& origin, stdx::vec3 const& invdir, float tmin, float tmax)
+{
+    for (uint a(0); a < 3; ++a)
+    {
+        float const t0 = (box.min_pt[a] - origin[a]) * invdir[a];
+        float const t1 = (box.max_pt[a] - origin[a]) * invdir[a];
+        tmin = std::max(tmin, std::min(t0, t1));
+        tmax = std::min(tmax, std::max(t0, t1));
+    }
+
+    return tmin <= tmax ? tmin : std::numeric_limits<float>::infinity();
+}
+
+trianglebvh::trianglebvh(std::span<stdx::vec3 const> positions, std::span<gfx::index const> indices, uint maxleafsize)
+{
+    _bvh = bvh(triangleboxes(positions, indices), maxleafsize);
+    gathertriangles(positions, indices);
+}
+
+bool trianglebvh::update(std::span<stdx::vec3 const> positions, std::span<gfx::index const> indices, float maxgrowth)
+{
+    bool const rebuilt = _bvh.update(triangleboxes(positions, indices), maxgrowth);
+    gathertriangles(positions, indices);
+    return rebuilt;
+}
+
+std::vector<aabb> trianglebvh::triangleboxes(std::span<stdx::vec3 const> positions, std::span<gfx::index const> indices)
+{
+    uint const numtris = indices.size() / 3;
+    std::vector<aabb> boxes(numtris);
+    stdx::parallel_for(stdx::range(numtris), [&](uint t)
+    {
+        stdx::vec3 const tri[3] = { positions[indices[t * 3].pos], positions[indices[t * 3 + 1].pos], positions[indices[t * 3 + 2].pos] };
+        boxes[t] = aabb(tri);
+    });
+
+    return boxes;
+}
+
+void trianglebvh::gathertriangles(std::span<stdx::vec3 const> positions, std::span<gfx::index const> indices)
+{
+    uint const numtris = indices.size() / 3;
+    auto const& order = _bvh.primitives();
+    _triangles.resize(numtris);
+    stdx::parallel_for(stdx::range(numtris), [&](uint i)
+    {
+        uint const t = order[i];
+        auto const& v0 = positions[indices[t * 3].pos];
+        _triangles[i] = { v0, positions[indices[t * 3 + 1].pos] - v0, positions[indices[t * 3 + 2].pos] - v0 };
+    });
+}
+
+// moller-trumbore
+std::optional<rayhit> trianglebvh::intersect(triangle const& tri, ray const& r, float tmax)
+{
+    auto const p = r.dir.cross(tri.e2);
+    float const det = tri.e1.dot(p);
+    if (std::abs(det) < std::numeric_limits<float>::min())
+        return {};
+
+    float const invdet = 1.f / det;
+    auto const s = r.origin - tri.v0;
+    float const u = s.dot(p) * invdet;
+    if (u < 0.f || u > 1.f)
+        return {};
+
+    auto const q = s.cross(tri.e1);
+    float const v = r.dir.dot(q) * invdet;
+    if (v < 0.f || u + v > 1.f)
+        return {};
+
+    float const t = tri.e2.dot(q) * invdet;
+    if (t < r.tmin || t >= tmax)
+        return {};
+
+    return rayhit{ t, u, v, 0 };
+}
+
+std::optional<rayhit> trianglebvh::nearest(ray const& r, raystats* stats) const
+{
+    std::optional<rayhit> res;
+    _bvh.traverse(r, [&](bvhnode const& leaf, float& tmax)
+    {
+        for (uint32 i(leaf.first); i < leaf.first + leaf.count; ++i)
+            if (auto hit = intersect(_triangles[i], r, tmax))
+            {
+                tmax = hit->t;
+                res = hit;
+                res->primitive = _bvh.primitives()[i];
+            }
+
+        return false;
+    }, stats);
+
+    return res;
+}
+
+std::optional<rayhit> trianglebvh::closesthit(ray const& r) const { return nearest(r, nullptr); }
+std::optional<rayhit> trianglebvh::closesthit(ray const& r, raystats& stats) const { return nearest(r, &stats); }
+
+bool trianglebvh::anyhit(ray const& r) const
+{
+    bool res = false;
+    _bvh.traverse(r, [&](bvhnode const& leaf, float& tmax)
+    {
+        for (uint32 i(leaf.first); i < leaf.first + leaf.count && !res; ++i)
+            res = intersect(_triangles[i], r, tmax).has_value();
+
+        return res;
+    });
+
+    return res;
+}
+
+void trianglebvh::closesthit(std::span<ray const> rays, std::span<std::optional<rayhit>> hits, uint grain) const
+{
+    stdx::parallel_for(stdx::range(rays.size()), [&](uint i) { hits[i] = closesthit(rays[i]); }, grain);
+}
+
+void trianglebvh::anyhit(std::span<ray const> rays, std::span<bool> hits, uint grain) const
+{
+    stdx::parallel_for(stdx::range(rays.size()), [&](uint i) { hits[i] = anyhit(rays[i]); }, grain);
+}
+
+
+namespace
+{
+
+using packet = trianglebvh8::packet;
+
+// a ray broadcast to all lanes
+struct raylanes
+{
+    explicit raylanes(ray const& r)
+    {
+        for (uint a(0); a < 3; ++a)
+        {
+            origin[a] = _mm256_set1_ps(r.origin[a]);
+            dir[a] = _mm256_set1_ps(r.dir[a]);
+        }
+    }
+
+    __m256 origin[3], dir[3];
+};
+
+__m256 load(std::array<float, trianglebvh8::width> const& v) { return _mm256_loadu_ps(v.data()); }
+
+// 8 bit child planes to floats
+__m256 load(std::array<uint8, trianglebvh8::width> const& q) { return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<__m128i const*>(q.data())))); }
+
+// moller-trumbore on 8 triangles, returns the mask of lanes hit within [tmin, tmax) and their t, u and v
+uint intersect(packet const& p, raylanes const& r, float tmin, float tmax, __m256& t, __m256& u, __m256& v)
+{
+    __m256 const e1[3] = { load(p.e1[0]), load(p.e1[1]), load(p.e1[2]) };
+    __m256 const e2[3] = { load(p.e2[0]), load(p.e2[1]), load(p.e2[2]) };
+    __m256 const s[3] = { _mm256_sub_ps(r.origin[0], load(p.v0[0])), _mm256_sub_ps(r.origin[1], load(p.v0[1])), _mm256_sub_ps(r.origin[2], load(p.v0[2])) };
+
+    auto const cross = [](__m256 const (&a)[3], __m256 const (&b)[3], __m256 (&res)[3])
+    {
+        res[0] = _mm256_fmsub_ps(a[1], b[2], _mm256_mul_ps(a[2], b[1]));
+        res[1] = _mm256_fmsub_ps(a[2], b[0], _mm256_mul_ps(a[0], b[2]));
+        res[2] = _mm256_fmsub_ps(a[0], b[1], _mm256_mul_ps(a[1], b[0]));
+    };
+
+    auto const dot = [](__m256 const (&a)[3], __m256 const (&b)[3]) { return _mm256_fmadd_ps(a[0], b[0], _mm256_fmadd_ps(a[1], b[1], _mm256_mul_ps(a[2], b[2]))); };
+
+    __m256 pv[3], qv[3];
+    cross(r.dir, e2, pv);
+    cross(s, e1, qv);
+
+    __m256 const det = dot(e1, pv);
+    __m256 const invdet = _mm256_div_ps(_mm256_set1_ps(1.f), det);
+    u = _mm256_mul_ps(dot(s, pv), invdet);
+    v = _mm256_mul_ps(dot(r.dir, qv), invdet);
+    t = _mm256_mul_ps(dot(e2, qv), invdet);
+
+    // degenerate padding lanes have a zero determinant
+    __m256 const absdet = _mm256_andnot_ps(_mm256_set1_ps(-0.f), det);
+    __m256 mask = _mm256_cmp_ps(absdet, _mm256_set1_ps(std::numeric_limits<float>::min()), _CMP_GE_OQ);
+    mask = _mm256_and_ps(mask, _mm256_cmp_ps(u, _mm256_setzero_ps(), _CMP_GE_OQ));
+    mask = _mm256_and_ps(mask, _mm256_cmp_ps(v, _mm256_setzero_ps(), _CMP_GE_OQ));
+    mask = _mm256_and_ps(mask, _mm256_cmp_ps(_mm256_add_ps(u, v), _mm256_set1_ps(1.f), _CMP_LE_OQ));
+    mask = _mm256_and_ps(mask, _mm256_cmp_ps(t, _mm256_set1_ps(tmin), _CMP_GE_OQ));
+    mask = _mm256_and_ps(mask, _mm256_cmp_ps(t, _mm256_set1_ps(tmax), _CMP_LT_OQ));
+    return uint(_mm256_movemask_ps(mask));
+}
+
+// the smallest power of two scale that spans the node in 255 steps
+void setgrid(trianglebvh8::node& n, aabb const& bounds)
+{
+    for (uint a(0); a < 3; ++a)
+    {
+        int exponent;
+        std::frexp((bounds.max_pt[a] - bounds.min_pt[a]) / 255.f, &exponent);
+        n.origin[a] = bounds.min_pt[a];
+        n.exponent[a] = uint8(std::clamp(exponent + 127, 1, 254));
+    }
+}
+
+// quantizes a child box conservatively on the node's grid
+void quantize(trianglebvh8::node& n, uint slot, aabb const& box)
+{
+    for (uint a(0); a < 3; ++a)
+    {
+        float const scale = std::bit_cast<float>(uint32(n.exponent[a]) << 23);
+        float lo = std::clamp(std::floor((box.min_pt[a] - n.origin[a]) / scale), 0.f, 255.f);
+        float hi = std::clamp(std::ceil((box.max_pt[a] - n.origin[a]) / scale), 0.f, 255.f);
+
+        // the subtraction rounds, so step out until the decoded planes enclose the box
+        while (lo > 0.f && n.origin[a] + lo * scale > box.min_pt[a]) lo -= 1.f;
+        while (hi < 255.f && n.origin[a] + hi * scale < box.max_pt[a]) hi += 1.f;
+
+        n.qmin[a][slot] = uint8(lo);
+        n.qmax[a][slot] = uint8(hi);
+    }
+}
+
+}
+
+trianglebvh8::trianglebvh8(trianglebvh const& binary)
+{
+    auto const& nodes = binary._bvh.nodes();
+    if (nodes.empty())
+        return;
+
+    // primitive range of every subtree, children are allocated after their parent so a reverse sweep sees them first
+    std::vector<std::pair<uint32, uint32>> ranges(nodes.size());
+    for (uint i(nodes.size()); i-- > 0;)
+    {
+        auto const& n = nodes[i];
+        ranges[i] = n.leaf() ? std::pair{ n.first, n.count } : std::pair{ ranges[n.first].first, ranges[n.first].second + ranges[n.first + 1].second };
+    }
+
+    collapse(binary, ranges, 0);
+}
+
+uint32 trianglebvh8::collapse(trianglebvh const& binary, std::vector<std::pair<uint32, uint32>> const& ranges, uint32 root)
+{
+    auto const& nodes = binary._bvh.nodes();
+    uint32 const nodeidx = uint32(_nodes.size());
+    _nodes.emplace_back();
+
+    // open up the largest children until there are 8 or all of them fit a packet
+    std::array<uint32, width> children{ root };
+    uint numchildren = 1;
+    while (numchildren < width)
+    {
+        uint best = width;
+        float bestarea = -1.f;
+        for (uint c(0); c < numchildren; ++c)
+        {
+            auto const& n = nodes[children[c]];
+            if (!n.leaf() && ranges[children[c]].second > width && halfarea(n.bounds) > bestarea)
+            {
+                best = c;
+                bestarea = halfarea(n.bounds);
+            }
+        }
+
+        if (best == width)
+            break;
+
+        uint32 const first = nodes[children[best]].first;
+        children[best] = first;
+        children[numchildren++] = first + 1;
+    }
+
+    node res{};
+    aabb bounds = emptybox();
+    for (uint c(0); c < numchildren; ++c)
+        bounds = merge(bounds, nodes[children[c]].bounds);
+
+    setgrid(res, bounds);
+    res.numchildren = uint8(numchildren);
+    for (uint c(0); c < numchildren; ++c)
+    {
+        quantize(res, c, nodes[children[c]].bounds);
+
+        auto const [first, count] = ranges[children[c]];
+        if (count <= width)
+            res.children[c] = addpacket(binary, first, count);
+        else if (nodes[children[c]].leaf())
+            res.children[c] = splitleaf(binary, first, count);
+        else
+            res.children[c] = collapse(binary, ranges, children[c]);
+    }
+
+    _nodes[nodeidx] = res;
+    return nodeidx;
+}
+
+uint32 trianglebvh8::splitleaf(trianglebvh const& binary, uint32 first, uint32 count)
+{
+    uint32 const nodeidx = uint32(_nodes.size());
+    _nodes.emplace_back();
+
+    // consecutive packets while the leaf fits 8 of them, otherwise 8 consecutive ranges split again
+    uint32 const partsize = std::max(uint32(width), uint32((count + width - 1) / width));
+    std::array<aabb, width> partbounds;
+    aabb bounds = emptybox();
+    uint numchildren = 0;
+    for (uint32 b(first); b < first + count; b += partsize, ++numchildren)
+    {
+        partbounds[numchildren] = emptybox();
+        for (uint32 i(b); i < std::min(b + partsize, first + count); ++i)
+        {
+            auto const& tri = binary._triangles[i];
+            partbounds[numchildren] = merge(partbounds[numchildren], aabb(tri.v0, tri.v0));
+            partbounds[numchildren] = merge(partbounds[numchildren], aabb(tri.v0 + tri.e1, tri.v0 + tri.e1));
+            partbounds[numchildren] = merge(partbounds[numchildren], aabb(tri.v0 + tri.e2, tri.v0 + tri.e2));
+        }
+
+        bounds = merge(bounds, partbounds[numchildren]);
+    }
+
+    node res{};
+    setgrid(res, bounds);
+    res.numchildren = uint8(numchildren);
+    for (uint c(0); c < numchildren; ++c)
+    {
+        quantize(res, c, partbounds[c]);
+
+        uint32 const b = first + c * partsize, n = std::min(partsize, first + count - b);
+        res.children[c] = n <= width ? addpacket(binary, b, n) : splitleaf(binary, b, n);
+    }
+
+    _nodes[nodeidx] = res;
+    return nodeidx;
+}
+
+uint32 trianglebvh8::addpacket(trianglebvh const& binary, uint32 first, uint32 count)
+{
+    packet p{};
+    p.primitives.fill(std::numeric_limits<uint32>::max());
+    for (uint l(0); l < count; ++l)
+    {
+        auto const& tri = binary._triangles[first + l];
+        for (uint a(0); a < 3; ++a)
+        {
+            p.v0[a][l] = tri.v0[a];
+            p.e1[a][l] = tri.e1[a];
+            p.e2[a][l] = tri.e2[a];
+        }
+
+        p.primitives[l] = binary._bvh.primitives()[first + l];
+    }
+
+    _packets.push_back(p);
+    return uint32(_packets.size() - 1) | leafbit;
+}
+
+template<bool anyhit_v>
+std::optional<rayhit> trianglebvh8::trace(ray const& r, raystats* stats) const
+{
+    std::optional<rayhit> res;
+    if (_nodes.empty())
+        return res;
+
+    auto const invdir = r.invdir();
+
+    raylanes const lanes(r);
+    float tmax = r.tmax;
+
+    // a node pushes at most width - 1 more entries than it pops per level
+    // entries are left uninitialized, a std::pair would zero all 6 KB of them for every ray
+    struct entry
+    {
+        uint32 ref;
+        float tentry;
+    };
+
+    std::array<entry, width * bvh::maxdepth> stack;
+    uint top = 0;
+    stack[top++] = { 0, r.tmin };
+    while (top > 0)
+    {
+        auto const [ref, tentry] = stack[--top];
+        if (tentry > tmax)
+            continue;
+
+        if (stats)
+            ++((ref & leafbit) ? stats->leaves : stats->nodes);
+
+        if (ref & leafbit)
+        {
+            auto const& p = _packets[ref & ~leafbit];
+            __m256 t, u, v;
+            uint const mask = intersect(p, lanes, r.tmin, tmax, t, u, v);
+            if (mask == 0)
+                continue;
+
+            if constexpr (anyhit_v)
+                return rayhit{};
+
+            alignas(32) float ts[width], us[width], vs[width];
+            _mm256_store_ps(ts, t);
+            _mm256_store_ps(us, u);
+            _mm256_store_ps(vs, v);
+            for (uint m(mask); m != 0; m &= m - 1)
+            {
+                uint const l = std::countr_zero(m);
+                if (ts[l] < tmax)
+                {
+                    tmax = ts[l];
+                    res = rayhit{ ts[l], us[l], vs[l], p.primitives[l] };
+                }
+            }
+
+            continue;
+        }
+
+        auto const& n = _nodes[ref];
+        __m256 tnear = _mm256_set1_ps(r.tmin), tfar = _mm256_set1_ps(tmax);
+        for (uint a(0); a < 3; ++a)
+        {
+            // origin + q * scale - ray origin, times the inverse direction
+            float const scale = std::bit_cast<float>(uint32(n.exponent[a]) << 23);
+            __m256 const s = _mm256_set1_ps(scale * invdir[a]);
+            __m256 const b = _mm256_set1_ps((n.origin[a] - r.origin[a]) * invdir[a]);
+            __m256 const t0 = _mm256_fmadd_ps(load(n.qmin[a]), s, b);
+            __m256 const t1 = _mm256_fmadd_ps(load(n.qmax[a]), s, b);
+            tnear = _mm256_max_ps(tnear, _mm256_min_ps(t0, t1));
+            tfar = _mm256_min_ps(tfar, _mm256_max_ps(t0, t1));
+        }
+
+        uint mask = uint(_mm256_movemask_ps(_mm256_cmp_ps(tnear, tfar, _CMP_LE_OQ))) & ((1u << n.numchildren) - 1);
+        if (mask == 0)
+            continue;
+
+        alignas(32) float ts[width];
+        _mm256_store_ps(ts, tnear);
+
+        // farther children go on the stack first so the nearest is visited next
+        // at most 8 of them, insertion sorted straight into the stack
+        uint const first = top;
+        for (; mask != 0; mask &= mask - 1)
+        {
+            uint const c = std::countr_zero(mask);
+            entry const hit = { n.children[c], ts[c] };
+            uint i = top++;
+            for (; i > first && stack[i - 1].tentry < hit.tentry; --i)
+                stack[i] = stack[i - 1];
+
+            stack[i] = hit;
+        }
+    }
+
+    return res;
+}
+
+std::optional<rayhit> trianglebvh8::closesthit(ray const& r) const { return trace<false>(r); }
+bool trianglebvh8::anyhit(ray const& r) const { return trace<true>(r).has_value(); }
+std::optional<rayhit> trianglebvh8::closesthit(ray const& r, raystats& stats) const { return trace<false>(r, &stats); }
+
+void trianglebvh8::closesthit(std::span<ray const> rays, std::span<std::optional<rayhit>> hits, uint grain) const
+{
+    stdx::parallel_for(stdx::range(rays.size()), [&](uint i) { hits[i] = closesthit(rays[i]); }, grain);
+}
+
+void trianglebvh8::anyhit(std::span<ray const> rays, std::span<bool> hits, uint grain) const
+{
+    stdx::parallel_for(stdx::range(rays.size()), [&](uint i) { hits[i] = anyhit(rays[i]); }, grain);
+}
+
+}
@@ -0,0 +1,285 @@
+export module geometry:bvh;
+
+import stdxcore;
+import stdx;
+import vec;
+import std;
+import :shapes;
+
+import graphicscore;
+
+export namespace geometry
+{
+
+struct ray
+{
+    ray() = default;
+    ray(stdx::vec3 const& _origin, stdx::vec3 const& _dir, float _tmax = std::numeric_limits<float>::max()) : origin(_origin), dir(_dir), tmax(_tmax) {}
+
+    // axis parallel rays get a tiny direction instead, so slabs never multiply zero by infinity
+    stdx::vec3 invdir() const
+    {
+        stdx::vec3 res;
+        for (uint a(0); a < 3; ++a)
+            res[a] = 1.f / (std::abs(dir[a]) > 1e-20f ? dir[a] : std::copysign(1e-20f, dir[a]));
+        return res;
+    }
+
+    stdx::vec3 origin, dir;
+    float tmin = 0.f;
+    float tmax = std::numeric_limits<float>::max();
+};
+
+struct rayhit
+{
+    float t;
+
+    // barycentrics of the triangle's second and third vertex
+    float u, v;
+    uint32 primitive;
+};
+
+// interior nodes whose children a query tested and leaves whose triangles it tested
+struct raystats
+{
+    uint nodes = 0;
+    uint leaves = 0;
+};
+
+struct bvhnode
+{
+    bool leaf() const { return count > 0; }
+
+    aabb bounds;
+
+    // leaves hold count primitives from first, interior nodes have count 0 and their children at first and first + 1
+    uint32 first = 0;
+    uint32 count = 0;
+};
+
+// bounding volume hierarchy over boxes, primitives are the indices of the boxes it was built from
+class bvh
+{
+public:
+    // deep enough for the traversal stack, the sah build splits at the median past half of it
+    // and the linear build splits on at most 63 morton bits and then 32 bits of the primitive's sorted position
+    static constexpr uint maxdepth = 96;
+
+    bvh() = default;
+
+    // binned surface area heuristic build, large nodes are split in parallel
+    explicit bvh(std::span<aabb const> boxes, uint maxleafsize = 4);
+
+    // linear build for hierarchies rebuilt every frame, primitives are radix sorted along a morton curve through their centroids
+    // coordbits of 10 or 21 give 30 or 63 bit codes, leaves hold a single primitive
+    // every step runs in parallel, but the tree is slower to trace than the sah build
+    static bvh linear(std::span<aabb const> boxes, uint coordbits = 10);
+
+    std::vector<bvhnode> const& nodes() const { return _nodes; }
+    std::vector<uint32> const& primitives() const { return _primitives; }
+
+    // expected cost of a ray through the tree in primitive tests, a traversal step costs as much as one
+    float sahcost() const;
+
+    // recomputes the node bounds bottom up for boxes that moved, boxes are indexed like the ones the tree was built from
+    // the topology doesn't change, so the tree gets worse as primitives drift apart from their neighbours
+    // returns the sah cost relative to the cost right after the last build
+    float refit(std::span<aabb const> boxes);
+
+    // refits, and rebuilds the same way the tree was first built once the sah cost has grown past maxgrowth times the built cost
+    // returns true if it rebuilt
+    bool update(std::span<aabb const> boxes, float maxgrowth = 1.5f);
+
+    // what the last refit returned, also when update rebuilt after it
+    float lastgrowth() const { return _lastgrowth; }
+
+    // calls leaf(node, tmax) for the leaves the ray reaches, nearer children first
+    // leaf can shorten tmax to cull farther nodes and returns true to end the traversal
+    // stats, if given, counts the interior nodes and leaves visited
+    template<typename leaf_t>
+    void traverse(ray const& r, leaf_t&& leaf, raystats* stats = nullptr) const;
+
+    // distance along the ray to where it enters the box, infinity if it misses the box within [tmin, tmax]
+    static float intersect(aabb const& box, stdx::vec3 const& origin, stdx::vec3 const& invdir, float tmin, float tmax);
+
+private:
+    std::vector<bvhnode> _nodes;
+    std::vector<uint32> _primitives;
+
+    // parent of every node but the root, set up by the first refit
+    std::vector<uint32> _parents;
+
+    // what update rebuilds with, a linear build has coordbits > 0
+    uint _maxleafsize = 4;
+    uint _coordbits = 0;
+    float _builtcost = 0.f;
+    float _lastgrowth = 1.f;
+};
+
+class trianglebvh8;
+
+// bvh over the triangles of a mesh with closest and any hit ray queries
+class trianglebvh
+{
+public:
+    trianglebvh() = default;
+    trianglebvh(std::span<stdx::vec3 const> positions, std::span<gfx::index const> indices, uint maxleafsize = 4);
+
+    // gfx::model or anything else with vertices().positions and a triangle list in indices()
+    template<typename model_t>
+    explicit trianglebvh(model_t const& model, uint maxleafsize = 4) : trianglebvh(model.vertices().positions, model.indices(), maxleafsize) {}
+
+    bvh const& hierarchy() const { return _bvh; }
+
+    // follows a deformation of the mesh the tree was built for, the indices have to be the same
+    // refits the bvh and rebuilds it past maxgrowth like bvh::update, returns true if it rebuilt
+    bool update(std::span<stdx::vec3 const> positions, std::span<gfx::index const> indices, float maxgrowth = 1.5f);
+
+    // rayhit::primitive is the index of the triangle in the index stream
+    std::optional<rayhit> closesthit(ray const& r) const;
+    bool anyhit(ray const& r) const;
+
+    // the same query, also counting the nodes and leaves it visits
+    std::optional<rayhit> closesthit(ray const& r, raystats& stats) const;
+
+    // a query per ray, spread over the job system
+    void closesthit(std::span<ray const> rays, std::span<std::optional<rayhit>> hits, uint grain = 0) const;
+    void anyhit(std::span<ray const> rays, std::span<bool> hits, uint grain = 0) const;
+
+private:
+    friend class trianglebvh8;
+
+    // first vertex and the edges to the other two
+    struct triangle
+    {
+        stdx::vec3 v0, e1, e2;
+    };
+
+    static std::optional<rayhit> intersect(triangle const& tri, ray const& r, float tmax);
+    std::optional<rayhit> nearest(ray const& r, raystats* stats) const;
+
+    static std::vector<aabb> triangleboxes(std::span<stdx::vec3 const> positions, std::span<gfx::index const> indices);
+    void gathertriangles(std::span<stdx::vec3 const> positions, std::span<gfx::index const> indices);
+
+    bvh _bvh;
+
+    // triangles in the bvh's primitive order, so leaves read them contiguously
+    std::vector<triangle> _triangles;
+};
+
+// 8 wide bvh collapsed from a trianglebvh, a node tests the boxes of all its children at once and a leaf up to 8 triangles at once with avx2
+// binary leaves with more than 8 triangles get a node of their own over several packets
+class trianglebvh8
+{
+public:
+    static constexpr uint width = 8;
+
+    // children with this bit set are indices of triangle packets, otherwise of nodes
+    static constexpr uint32 leafbit = 0x80000000u;
+
+    // child boxes are quantized to 8 bits per plane on a grid of origin + q * scale, scale is a power of two
+    // stored by its biased float exponent
+    struct node
+    {
+        std::array<float, 3> origin;
+        std::array<uint8, 3> exponent;
+        uint8 numchildren;
+        std::array<std::array<uint8, width>, 3> qmin;
+        std::array<std::array<uint8, width>, 3> qmax;
+        std::array<uint32, width> children;
+    };
+
+    // structure of arrays triangles, lanes past the leaf's triangles are degenerate and never hit
+    struct packet
+    {
+        std::array<std::array<float, width>, 3> v0;
+        std::array<std::array<float, width>, 3> e1;
+        std::array<std::array<float, width>, 3> e2;
+        std::array<uint32, width> primitives;
+    };
+
+    trianglebvh8() = default;
+    explicit trianglebvh8(trianglebvh const& binary);
+
+    std::vector<node> const& nodes() const { return _nodes; }
+    std::vector<packet> const& packets() const { return _packets; }
+
+    std::optional<rayhit> closesthit(ray const& r) const;
+    bool anyhit(ray const& r) const;
+    std::optional<rayhit> closesthit(ray const& r, raystats& stats) const;
+
+    void closesthit(std::span<ray const> rays, std::span<std::optional<rayhit>> hits, uint grain = 0) const;
+    void anyhit(std::span<ray const> rays, std::span<bool> hits, uint grain = 0) const;
+
+private:
+    uint32 collapse(trianglebvh const& binary, std::vector<std::pair<uint32, uint32>> const& ranges, uint32 root);
+    uint32 splitleaf(trianglebvh const& binary, uint32 first, uint32 count);
+    uint32 addpacket(trianglebvh const& binary, uint32 first, uint32 count);
+
+    template<bool anyhit_v>
+    std::optional<rayhit> trace(ray const& r, raystats* stats = nullptr) const;
+
+    std::vector<node> _nodes;
+    std::vector<packet> _packets;
+};
+
+template<typename leaf_t>
+void bvh::traverse(ray const& r, leaf_t&& leaf, raystats* stats) const
+{
+    if (_nodes.empty())
+        return;
+
+    auto const invdir = r.invdir();
+    float tmax = r.tmax;
+    if (intersect(_nodes[0].bounds, r.origin, invdir, r.tmin, tmax) == std::numeric_limits<float>::infinity())
+        return;
+
+    // nodes still to visit with the distance the ray enters them
+    // uninitialized unlike a std::pair, which would zero every entry for every ray
+    struct entry
+    {
+        uint32 node;
+        float tentry;
+    };
+
+    std::array<entry, maxdepth> stack;
+    uint top = 0;
+    uint32 node = 0;
+    for (;;)
+    {
+        auto const& n = _nodes[node];
+        if (stats)
+            ++(n.leaf() ? stats->leaves : stats->nodes);
+
+        if (n.leaf())
+        {
+            if (leaf(n, tmax))
+                return;
+        }
+        else
+        {
+            float const tl = intersect(_nodes[n.first].bounds, r.origin, invdir, r.tmin, tmax);
+            float const tr = intersect(_nodes[n.first + 1].bounds, r.origin, invdir, r.tmin, tmax);
+            if (tl != std::numeric_limits<float>::infinity() || tr != std::numeric_limits<float>::infinity())
+            {
+                uint32 const near = tl <= tr ? n.first : n.first + 1;
+                if (std::max(tl, tr) != std::numeric_limits<float>::infinity())
+                    stack[top++] = { near == n.first ? n.first + 1 : n.first, std::max(tl, tr) };
+
+                node = near;
+                continue;
+            }
+        }
+
+        // skip nodes a closer hit has moved past
+        do
+        {
+            if (top == 0)
+                return;
+
+            node = stack[--top].node;
+        } while (stack[top].tentry > tmax);
+    }
+}
+
+}
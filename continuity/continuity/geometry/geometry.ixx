@@ -1,5 +1,7 @@
 export module geometry;
 export import :shapes;
+export import :bvh;
+export import :aabbset;
 
 import stdxcore;
 import vec;
@@ -14,6 +14,7 @@ import vec;
 import std;
 
 import graphics;
+import :aabbset;
 
 namespace geometry
 {
@@ -170,19 +171,7 @@ aabb::aabb(stdx::vec3 const (&tri)[3])
 
 aabb::aabb(std::vector<stdx::vec3> const& points) : aabb(points.data(), points.size()) {}
 
-aabb::aabb(stdx::vec3 const* points, uint len)
-{
-    for (uint i = 0; i < len; ++i)
-    {
-        min_pt[0] = std::min(points[i][0], min_pt[0]);
-        min_pt[1] = std::min(points[i][1], min_pt[1]);
-        min_pt[2] = std::min(points[i][2], min_pt[2]);
-
-        max_pt[0] = std::max(points[i][0], max_pt[0]);
-        max_pt[1] = std::max(points[i][1], max_pt[1]);
-        max_pt[2] = std::max(points[i][2], max_pt[2]);
-    }
-}
+aabb::aabb(stdx::vec3 const* points, uint len) : aabb(bounds({ points, len })) {}
 
 aabb& aabb::operator+=(stdx::vec3 const& pt)
 {
@@ -201,7 +190,7 @@ stdx::vec3 aabb::bound(stdx::vec3 const& pt) const
 {
     stdx::vec3 localpt = pt - center();
     stdx::vec3 halfextents = span() / 2.0f;
-    return stdx::vec3{ std::min(std::abs(localpt[0]), halfextents[0]) * stdx::sign(localpt[0]), std::min(std::abs(localpt[0]), halfextents[0]) * stdx::sign(localpt[0]), std::min(std::abs(localpt[2]), halfextents[2]) * stdx::sign(localpt[2]) } + center();
+    return stdx::vec3{ std::min(std::abs(localpt[0]), halfextents[0]) * stdx::sign(localpt[0]), std::min(std::abs(localpt[1]), halfextents[1]) * stdx::sign(localpt[1]), std::min(std::abs(localpt[2]), halfextents[2]) * stdx::sign(localpt[2]) } + center();
     //stdx::vec3 halfextents = span() / 2.0f;
     //return stdx::clamp(localpt, -halfextents, halfextents);
 }
@@ -277,7 +266,7 @@ std::vector<gfx::vertex> cube::vertices_flipped() const
     return invertedvertices;
 }
 
-std::vector<gfx::instance_data> cube::instancedata() const { return { gfx::instance_data(matrix::CreateTranslation(center)) }; }
+std::vector<gfx::instance_data> cube::instancedata() const { return { gfx::instance_data(stdx::matrix4x4::translation({ center.x, center.y, center.z })) }; }
 
 stdx::vec3 tovec3(vector3 const & v)
 {
@@ -304,7 +293,7 @@ void sphere::generate_triangles()
     generate_triangles(unitspheres_tessellated[numsegments_longitude]);
 }
 
-std::vector<gfx::instance_data> sphere::instancedata() const { return { gfx::instance_data(matrix::CreateTranslation(center)) }; }
+std::vector<gfx::instance_data> sphere::instancedata() const { return { gfx::instance_data(stdx::matrix4x4::translation(tovec3(center))) }; }
 
 void sphere::generate_triangles(std::vector<vector3> const& unitsphere_triangles)
 {
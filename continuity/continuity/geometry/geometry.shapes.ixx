@@ -8,11 +8,11 @@ import stdxcore;
 import graphicscore;
 import std;
 import vec;
+import flathash;
 
 using namespace DirectX;
 using vector3 = DirectX::SimpleMath::Vector3;
 using vector4 = DirectX::SimpleMath::Vector4;
-using matrix = DirectX::SimpleMath::Matrix;
 
 export namespace geometry
 {
@@ -93,8 +93,7 @@ private:
 
     std::vector<gfx::vertex> triangulated_sphere;
 
-    // can't use std::unordered_map for some reason
-    static inline std::map<uint, std::vector<vector3>> unitspheres_tessellated;
+    static inline stdx::flathashmap<uint, std::vector<vector3>> unitspheres_tessellated;
 };
 
 }
\ No newline at end of file
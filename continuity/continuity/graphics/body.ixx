@@ -10,6 +10,7 @@ export module body;
 
 import vec;
 import stdxcore;
+import memory;
 import geometry;
 import graphicscore;
 import graphics;
@@ -58,6 +59,13 @@ concept hasinstancedata = requires(t v)
     { v.instancedata() } -> std::convertible_to<std::vector<instance_data>>;
 };
 
+// instance data can be built in frame memory instead of a new vector every frame
+template<typename t>
+concept hasframeinstancedata = requires(t v, std::pmr::memory_resource* mem)
+{
+    { v.instancedata(mem) } -> std::convertible_to<std::span<instance_data const>>;
+};
+
 template<typename t>
 concept hastexturedata = requires(t v)
 {
@@ -141,6 +149,7 @@ class body_static : public bodyinterface
     vertexfetch get_vertices;
     indexfetch get_indices;
     instancedatafetch get_instancedata;
+    bool frameinstancedata = false;
 
 public:
 
@@ -209,6 +218,7 @@ inline body_static<body_t, prim_t>::body_static(body_c_t&& _body, bodyparams con
     get_vertices = [](body_t const& geom) { return geom.vertices(); };
     get_instancedata = [](body_t const& geom) { return geom.instancedata(); };
     get_indices = [](body_t const& geom) { return geom.indices(); };
+    frameinstancedata = hasframeinstancedata<rawbody_t>;
 }
 
 template<sbody_c body_t, topology prim_t>
@@ -270,6 +280,15 @@ void body_static<body_t, prim_t>::update(float dt)
     // update only if we own this body
     if constexpr (std::is_same_v<body_t, rawbody_t> && hasupdate<rawbody_t>) body.update(dt);
 
+    if constexpr (hasframeinstancedata<rawbody_t>)
+    {
+        if (frameinstancedata)
+        {
+            _objconstants.update(body.instancedata(&stdx::framearena::get()));
+            return;
+        }
+    }
+
     auto bodydata = get_instancedata(body);
 
     // only one instance right now 
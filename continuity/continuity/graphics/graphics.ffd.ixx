@@ -0,0 +1,325 @@
+module;
+
+#include "simplemath/simplemath.h"
+
+export module graphics:ffd;
+
+import stdxcore;
+import stdx;
+import jobs;
+import flathash;
+import beziermaths;
+import std;
+import :model;
+
+import graphicscore;
+
+export namespace gfx
+{
+
+// free form deformation of a model by a grid of degree n bezier volume cells spanning its bounds
+// neighbouring cells share the control points on their common faces, so the lattice is continuous across cells
+// every vertex is bound to the cell it lies in with its bernstein weights cached, a control point move then adds its change times the weight
+// a control point only belongs to the cells around it, up to 8 at a cell corner, so a drag visits the vertices of those cells only
+// with a single cell the bernstein weights have global support and every drag visits the whole model
+// tangent frames follow each cell's own jacobian, the lattice is only continuous in position across cell faces
+// the model's vertices have to be uploaded again after deform
+template<uint n>
+class ffd
+{
+public:
+	using lattice_t = beziermaths::beziervolume<n>;
+	using cellidx = std::array<uint, 3>;
+
+	// tbns shared by several positions are split here, so each one follows the jacobian at its own position
+	explicit ffd(model& m, cellidx const& cells = { 1, 1, 1 }) : _cells(cells)
+	{
+		uint numcells = 1, numcontrolpts = 1;
+		for (uint a(0); a < 3; ++a)
+		{
+			stdx::cassert(_cells[a] > 0);
+			_dims[a] = _cells[a] * n + 1;
+			numcells *= _cells[a];
+			numcontrolpts *= _dims[a];
+		}
+
+		auto const& positions = m._vertices.positions;
+		if (positions.empty())
+			return;
+
+		vector3 lo(positions[0][0], positions[0][1], positions[0][2]), hi = lo;
+		for (auto const& p : positions)
+		{
+			lo = vector3::Min(lo, vector3(p[0], p[1], p[2]));
+			hi = vector3::Max(hi, vector3(p[0], p[1], p[2]));
+		}
+
+		// flat models still need a non zero extent to divide by
+		_origin = lo;
+		_extent = hi - lo;
+		for (uint a(0); a < 3; ++a)
+		{
+			(&_extent.x)[a] = (&_extent.x)[a] > 0.f ? (&_extent.x)[a] : 1.f;
+			(&_cellextent.x)[a] = (&_extent.x)[a] / float(_cells[a]);
+		}
+
+		_controlpts.resize(numcontrolpts);
+		for (uint c(0); c < numcontrolpts; ++c)
+		{
+			auto const idx = axisindices(c);
+			_controlpts[c] = _origin + _cellextent * vector3(float(idx[0]), float(idx[1]), float(idx[2])) / float(n);
+		}
+
+		_positions.reserve(positions.size());
+		_weights.resize(positions.size());
+		_jacobians.resize(positions.size(), { vector3(_cellextent.x, 0.f, 0.f), vector3(0.f, _cellextent.y, 0.f), vector3(0.f, 0.f, _cellextent.z) });
+		_cellvertices.resize(numcells);
+		for (uint p(0); p < positions.size(); ++p)
+		{
+			vector3 const pos(positions[p][0], positions[p][1], positions[p][2]);
+			_positions.push_back(pos);
+
+			auto const [cell, uvw] = locate(pos);
+			for (uint a(0); a < 3; ++a)
+				std::tie(_weights[p].b[a], _weights[p].db[a]) = beziermaths::bernstein<n>((&uvw.x)[a]);
+
+			_cellvertices[cellindex(cell)].push_back(p);
+		}
+
+		bindtbns(m);
+	}
+
+	// control points per axis, cells * n + 1
+	cellidx const& dims() const { return _dims; }
+
+	// control points run along x fastest, then y, then z
+	uint controlpointindex(cellidx const& idx) const { return idx[0] + _dims[0] * (idx[1] + _dims[1] * idx[2]); }
+	vector3 const& controlpoint(uint c) const { return _controlpts[c]; }
+
+	// the bezier volume of one cell, with the control points it shares with its neighbours
+	lattice_t cell(cellidx const& idx) const
+	{
+		lattice_t r;
+		for (uint l(0); l < lattice_t::numcontrolpts; ++l)
+		{
+			auto const local = localindices(l);
+			r[l] = _controlpts[controlpointindex({ idx[0] * n + local[0], idx[1] * n + local[1], idx[2] * n + local[2] })];
+		}
+
+		return r;
+	}
+
+	uint numvertices(cellidx const& idx) const { return _cellvertices[cellindex(idx)].size(); }
+
+	// deformed position of a rest position and the model space partial derivatives there, evaluated from its cell's lattice
+	std::array<vector3, 4> evaluate(vector3 const& rest) const
+	{
+		auto const [idx, uvw] = locate(rest);
+		auto r = beziermaths::evaluatepartials(cell(idx), uvw);
+		for (uint a(0); a < 3; ++a)
+			r[a + 1] = r[a + 1] / (&_cellextent.x)[a];
+
+		return r;
+	}
+
+	// the model follows on the next deform
+	void movecontrolpoint(uint c, vector3 const& pos)
+	{
+		vector3 const delta = pos - _controlpts[c];
+		_controlpts[c] = pos;
+
+		auto const it = std::ranges::find(_pending, c, &move::controlpoint);
+		if (it != _pending.end())
+			it->delta += delta;
+		else
+			_pending.push_back({ c, delta });
+	}
+
+	// applies the moves since the last deform to the cells they reach, returns the number of vertices visited
+	uint deform(model& m, uint grain = 0)
+	{
+		// every move once per cell it belongs to, in that cell's own control point indices
+		std::vector<std::pair<uint, cellmove>> moves;
+		for (auto const& [c, delta] : _pending)
+		{
+			auto const idx = axisindices(c);
+
+			// a control point on a face between cells belongs to the cells on both sides of it
+			cellidx first, last;
+			for (uint a(0); a < 3; ++a)
+			{
+				first[a] = idx[a] == 0 ? 0 : (idx[a] - 1) / n;
+				last[a] = std::min(idx[a] / n, _cells[a] - 1);
+			}
+
+			for (uint z(first[2]); z <= last[2]; ++z)
+				for (uint y(first[1]); y <= last[1]; ++y)
+					for (uint x(first[0]); x <= last[0]; ++x)
+						moves.push_back({ cellindex({ x, y, z }), { { idx[0] - x * n, idx[1] - y * n, idx[2] - z * n }, delta } });
+		}
+
+		_pending.clear();
+		std::ranges::sort(moves, {}, &std::pair<uint, cellmove>::first);
+
+		uint touched = 0;
+		std::vector<cellmove> cellmoves;
+		for (uint i(0); i < moves.size();)
+		{
+			uint const cell = moves[i].first;
+			cellmoves.clear();
+			for (; i < moves.size() && moves[i].first == cell; ++i)
+				cellmoves.push_back(moves[i].second);
+
+			auto const& verts = _cellvertices[cell];
+			if (verts.empty())
+				continue;
+
+			stdx::parallel_for(stdx::range(verts.size()), [this, &m, &cellmoves, &verts](uint v) { deformvertex(m, verts[v], cellmoves); }, grain);
+			touched += verts.size();
+		}
+
+		return touched;
+	}
+
+private:
+	struct move
+	{
+		uint controlpoint;
+		vector3 delta;
+	};
+
+	struct cellmove
+	{
+		cellidx controlpoint;
+		vector3 delta;
+	};
+
+	// bernstein weights and their derivatives along each parameter axis of the vertex's cell
+	struct weights
+	{
+		std::array<std::array<float, n + 1>, 3> b;
+		std::array<std::array<float, n + 1>, 3> db;
+	};
+
+	cellidx axisindices(uint c) const { return { c % _dims[0], (c / _dims[0]) % _dims[1], c / (_dims[0] * _dims[1]) }; }
+
+	// control points in a cell run along x fastest, then z, then y, the order beziermaths::evaluatepartials uses
+	static constexpr cellidx localindices(uint l) { return { l % (n + 1), l / ((n + 1) * (n + 1)), (l / (n + 1)) % (n + 1) }; }
+
+	uint cellindex(cellidx const& idx) const { return idx[0] + _cells[0] * (idx[1] + _cells[1] * idx[2]); }
+
+	// the cell a position lies in and its parameters there, positions on a face between cells go to the upper one
+	std::pair<cellidx, vector3> locate(vector3 const& pos) const
+	{
+		std::pair<cellidx, vector3> r;
+		vector3 const t = (pos - _origin) / _cellextent;
+		for (uint a(0); a < 3; ++a)
+		{
+			float const ta = (&t.x)[a];
+			r.first[a] = std::min(uint(std::max(ta, 0.f)), _cells[a] - 1);
+			(&r.second.x)[a] = ta - float(r.first[a]);
+		}
+
+		return r;
+	}
+
+	void bindtbns(model& m)
+	{
+		auto& tbns = m._vertices.tbns;
+		constexpr uint32 unowned = std::numeric_limits<uint32>::max();
+
+		// copies of a tbn for each extra position it is used with, keyed by the tbn and the position
+		std::vector<uint32> owner(tbns.size(), unowned);
+		stdx::flathashmap<uint64, uint32> copies;
+		for (auto& idx : m._indices)
+		{
+			if (owner[idx.tbn] == unowned)
+				owner[idx.tbn] = idx.pos;
+
+			if (owner[idx.tbn] == idx.pos)
+				continue;
+
+			auto const [it, inserted] = copies.try_emplace((uint64(idx.tbn) << 32) | idx.pos, uint32(tbns.size()));
+			if (inserted)
+			{
+				tbns.push_back(tbns[idx.tbn]);
+				owner.push_back(idx.pos);
+			}
+
+			idx.tbn = it->second;
+		}
+
+		_resttbns = tbns;
+
+		// tbns of each position, _tbns[_tbnstart[p] .. _tbnstart[p + 1]]
+		_tbnstart.assign(_positions.size() + 1, 0);
+		for (auto const o : owner)
+			if (o != unowned)
+				++_tbnstart[o + 1];
+
+		std::partial_sum(_tbnstart.begin(), _tbnstart.end(), _tbnstart.begin());
+		_tbns.resize(_tbnstart.back());
+		auto next = _tbnstart;
+		for (uint32 t(0); t < owner.size(); ++t)
+			if (owner[t] != unowned)
+				_tbns[next[owner[t]]++] = t;
+	}
+
+	void deformvertex(model& m, uint p, std::vector<cellmove> const& moves)
+	{
+		auto const& w = _weights[p];
+		auto& jac = _jacobians[p];
+		for (auto const& [idx, delta] : moves)
+		{
+			float const bx = w.b[0][idx[0]], by = w.b[1][idx[1]], bz = w.b[2][idx[2]];
+			_positions[p] += delta * (bx * by * bz);
+			jac[0] += delta * (w.db[0][idx[0]] * by * bz);
+			jac[1] += delta * (bx * w.db[1][idx[1]] * bz);
+			jac[2] += delta * (bx * by * w.db[2][idx[2]]);
+		}
+
+		auto const& pos = _positions[p];
+		m._vertices.positions[p] = stdx::vec3{ pos.x, pos.y, pos.z };
+
+		// jacobian in model space, cell parameters are positions scaled by 1 / cell extent
+		vector3 const du = jac[0] / _cellextent.x, dv = jac[1] / _cellextent.y, dw = jac[2] / _cellextent.z;
+		auto const transform = [&](stdx::vec3 const& v) { return du * v[0] + dv * v[1] + dw * v[2]; };
+		auto const tostdx = [](vector3 v) { v.Normalize(); return stdx::vec3{ v.x, v.y, v.z }; };
+		for (uint t(_tbnstart[p]); t < _tbnstart[p + 1]; ++t)
+		{
+			auto const& rest = _resttbns[_tbns[t]];
+			auto& tbn = m._vertices.tbns[_tbns[t]];
+
+			// tangents go through the jacobian, normals through its cofactor so they stay perpendicular to the deformed surface
+			tbn.tangent = tostdx(transform(rest.tangent));
+			tbn.bitangent = tostdx(transform(rest.bitangent));
+			tbn.normal = tostdx(dv.Cross(dw) * rest.normal[0] + dw.Cross(du) * rest.normal[1] + du.Cross(dv) * rest.normal[2]);
+		}
+	}
+
+	cellidx _cells, _dims;
+	vector3 _origin, _extent, _cellextent;
+	std::vector<vector3> _controlpts;
+
+	// deformed positions and their cell parameter space jacobians, kept at full precision between deforms
+	std::vector<vector3> _positions;
+	std::vector<std::array<vector3, 3>> _jacobians;
+	std::vector<weights> _weights;
+	std::vector<std::vector<uint>> _cellvertices;
+
+	std::vector<tbn> _resttbns;
+	std::vector<uint32> _tbnstart;
+	std::vector<uint32> _tbns;
+
+	std::vector<move> _pending;
+};
+
+}
+
+namespace gfx
+{
+
+// compiled with the module rather than only where a lattice is used, quadratic is what the benchmarks drag
+template class ffd<2>;
+
+}
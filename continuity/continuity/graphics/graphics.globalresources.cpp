@@ -146,6 +146,8 @@ void globalresources::addcomputepso(std::string const& name, std::string const&
         stdx::cassert(false, "trying to add pso of speciifed name when it already exists");
     }
 
+    auto& objs = *(_psos[name] = std::make_unique<pipeline_objects>());
+
     shader computeshader;
     if (!cs.empty())
         ReadDataFromFile(assetfullpath(cs).c_str(), &computeshader.data, &computeshader.size);
@@ -158,7 +160,7 @@ void globalresources::addcomputepso(std::string const& name, std::string const&
     // todo : shouldn't need to create same root signature for every pso(can even be shared among graphics and compute)
     ComPtr<ID3D12RootSignature> rootsig;
     serialize_create_rootsignature(_device, rootsig_desc, &rootsig);
-    _psos[name].root_signature = rootsig;
+    objs.root_signature = rootsig;
 
     D3D12_COMPUTE_PIPELINE_STATE_DESC psodesc = {};
     psodesc.pRootSignature = rootsig.Get();
@@ -170,7 +172,7 @@ void globalresources::addcomputepso(std::string const& name, std::string const&
     stream_desc.pPipelineStateSubobjectStream = &psostream;
     stream_desc.SizeInBytes = sizeof(psostream);
 
-    ThrowIfFailed(_device->CreatePipelineState(&stream_desc, IID_PPV_ARGS(_psos[name].pso.GetAddressOf())));
+    ThrowIfFailed(_device->CreatePipelineState(&stream_desc, IID_PPV_ARGS(objs.pso.GetAddressOf())));
 }
 
 void globalresources::addpso(std::string const& name, std::string const& as, std::string const& ms, std::string const& ps, uint flags)
@@ -180,6 +182,8 @@ void globalresources::addpso(std::string const& name, std::string const& as, std
         stdx::cassert(false, "trying to add pso of speciifed name when it already exists");
     }
 
+    auto& objs = *(_psos[name] = std::make_unique<pipeline_objects>());
+
     shader ampshader, meshshader, pixelshader;
 
     if (!as.empty())
@@ -198,10 +202,10 @@ void globalresources::addpso(std::string const& name, std::string const& as, std
     ComPtr<ID3D12RootSignature> rootsig;
     serialize_create_rootsignature(_device, rootsig_desc, &rootsig);
 
-    _psos[name].root_signature = rootsig;
+    objs.root_signature = rootsig;
 
     D3DX12_MESH_SHADER_PIPELINE_STATE_DESC pso_desc = _psodesc;
-    pso_desc.pRootSignature = _psos[name].root_signature.Get();
+    pso_desc.pRootSignature = objs.root_signature.Get();
 
     if (!as.empty())
         pso_desc.AS = { ampshader.data, ampshader.size };
@@ -227,7 +231,7 @@ void globalresources::addpso(std::string const& name, std::string const& as, std
     stream_desc.pPipelineStateSubobjectStream = &psostream;
     stream_desc.SizeInBytes = sizeof(psostream);
 
-    ThrowIfFailed(_device->CreatePipelineState(&stream_desc, IID_PPV_ARGS(_psos[name].pso.GetAddressOf())));
+    ThrowIfFailed(_device->CreatePipelineState(&stream_desc, IID_PPV_ARGS(objs.pso.GetAddressOf())));
 
     if (flags & psoflags::wireframe)
     {
@@ -239,7 +243,7 @@ void globalresources::addpso(std::string const& name, std::string const& as, std
         D3D12_PIPELINE_STATE_STREAM_DESC stream_desc;
         stream_desc.pPipelineStateSubobjectStream = &psostream;
         stream_desc.SizeInBytes = sizeof(psostream);
-        ThrowIfFailed(_device->CreatePipelineState(&stream_desc, IID_PPV_ARGS(_psos[name].pso_wireframe.GetAddressOf())));
+        ThrowIfFailed(_device->CreatePipelineState(&stream_desc, IID_PPV_ARGS(objs.pso_wireframe.GetAddressOf())));
     }
 
     if (flags & psoflags::twosided)
@@ -251,7 +255,7 @@ void globalresources::addpso(std::string const& name, std::string const& as, std
         stream_desc_twosides.pPipelineStateSubobjectStream = &psostream_twosides;
         stream_desc_twosides.SizeInBytes = sizeof(psostream_twosides);
 
-        ThrowIfFailed(_device->CreatePipelineState(&stream_desc_twosides, IID_PPV_ARGS(_psos[name].pso_twosided.GetAddressOf())));
+        ThrowIfFailed(_device->CreatePipelineState(&stream_desc_twosides, IID_PPV_ARGS(objs.pso_twosided.GetAddressOf())));
     }
 }
 
@@ -260,9 +264,11 @@ gfx::pipeline_objects& globalresources::addraytracingpso(std::string const& name
     if (auto existing = _psos.find(name); existing != _psos.cend())
     {
         stdx::cassert(false, "trying to add pso of speciifed name when it already exists");
-        return _psos[name];
+        return *existing->second;
     }
 
+    auto& objs = *(_psos[name] = std::make_unique<pipeline_objects>());
+
     // global root signature is a root signature that is shared across all raytracing shaders invoked during a DispatchRays() call.
 
     {
@@ -278,7 +284,7 @@ gfx::pipeline_objects& globalresources::addraytracingpso(std::string const& name
         // empty root signature
         serialize_create_rootsignature(_device, rootsig_desc, &rootsig);
 
-        _psos[name].root_signature = rootsig;
+        objs.root_signature = rootsig;
     }
 
     // empty local root signature
@@ -288,7 +294,7 @@ gfx::pipeline_objects& globalresources::addraytracingpso(std::string const& name
         CD3DX12_ROOT_SIGNATURE_DESC localRootSignatureDesc(0, nullptr, 0, nullptr, D3D12_ROOT_SIGNATURE_FLAG_LOCAL_ROOT_SIGNATURE);
         serialize_create_rootsignature(_device, localRootSignatureDesc, &rootSig);
 
-        _psos[name].rootsignature_local = rootSig;
+        objs.rootsignature_local = rootSig;
     }
 
     shader raytracinglib;
@@ -334,20 +340,20 @@ gfx::pipeline_objects& globalresources::addraytracingpso(std::string const& name
 
     // empty local root signature
     auto localrootsignature = raytracingpipeline.CreateSubobject<CD3DX12_LOCAL_ROOT_SIGNATURE_SUBOBJECT>();
-    localrootsignature->SetRootSignature(_psos[name].rootsignature_local.Get());
+    localrootsignature->SetRootSignature(objs.rootsignature_local.Get());
 
     // global root signature
     // this is a root signature that is shared across all raytracing shaders invoked during a DispatchRays() call.
     auto globalrootsig = raytracingpipeline.CreateSubobject<CD3DX12_GLOBAL_ROOT_SIGNATURE_SUBOBJECT>();
-    globalrootsig->SetRootSignature(_psos[name].root_signature.Get());
+    globalrootsig->SetRootSignature(objs.root_signature.Get());
 
     auto pipelineconfig = raytracingpipeline.CreateSubobject<CD3DX12_RAYTRACING_PIPELINE_CONFIG_SUBOBJECT>();
     pipelineconfig->Config(31); // primary rays only. 
 
     // create the state object.
-    ThrowIfFailed(_device->CreateStateObject(raytracingpipeline, IID_PPV_ARGS(&_psos[name].pso_raytracing)));
+    ThrowIfFailed(_device->CreateStateObject(raytracingpipeline, IID_PPV_ARGS(&objs.pso_raytracing)));
 
-    return _psos[name];
+    return objs;
 }
 
 globalresources& globalresources::get()
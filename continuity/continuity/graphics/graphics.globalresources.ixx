@@ -10,6 +10,7 @@ export module graphics:globalresources;
 import stdxcore;
 import stdx;
 import vec;
+import flathash;
 import std;
 import :resourcetypes;
 
@@ -20,8 +21,8 @@ using Microsoft::WRL::ComPtr;
 export namespace gfx
 {
 
-using psomapref = std::unordered_map<std::string, pipeline_objects> const&;
-using matmapref = std::unordered_map<std::string, stdx::ext<material, bool>> const&;
+using psomapref = stdx::flathashmap<std::string, std::unique_ptr<pipeline_objects>> const&;
+using matmapref = stdx::flathashmap<std::string, stdx::ext<material, bool>> const&;
 using materialentry = stdx::ext<material, bool>;
 using materialcref = stdx::ext<material, bool> const&;
 
@@ -35,10 +36,11 @@ class globalresources
 
 	ComPtr<ID3D12Resource> _rendertarget;
 	ComPtr<ID3D12GraphicsCommandList6> _commandlist;
-	std::unordered_map<std::string, pipeline_objects> _psos;
+	// psos are boxed, references to them survive the map growing
+	stdx::flathashmap<std::string, std::unique_ptr<pipeline_objects>> _psos;
 
 	std::vector<material> _materials;
-	std::unordered_map<DXGI_FORMAT, uint> _dxgisizes{ {DXGI_FORMAT_R8G8B8A8_UNORM, 4} };
+	stdx::flathashmap<DXGI_FORMAT, uint> _dxgisizes{ {DXGI_FORMAT_R8G8B8A8_UNORM, 4} };
 	D3DX12_MESH_SHADER_PIPELINE_STATE_DESC _psodesc{};
 
 	uint32 _materialsbuffer_idx = stdx::invalid<uint32>;
@@ -16,6 +16,7 @@ export import :globalresources;
 export import :renderer;
 export import :renderpasses;
 export import :pathtrace;
+export import :ffd;
 
 import stdxcore;
 import stdx;
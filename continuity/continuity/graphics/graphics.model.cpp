@@ -6,6 +6,7 @@ module;
 module graphics:model;
 
 import vec;
+import jobs;
 import :globalresources;
 import engine;
 
@@ -207,16 +208,18 @@ model::model(std::string const& objpath, resourcelist& transientres, modelloadpa
         }
     }
 
-    for (auto i : stdx::range(_vertices.tbns.size()))
+    // faces scatter into shared tbns, but orthonormalization is independent per vertex
+    stdx::parallel_for(stdx::range(_vertices.tbns.size()), [&](uint i)
     {
         auto& n = _vertices.tbns[i].normal;
         auto& t = _vertices.tbns[i].tangent;
         auto& b = _vertices.tbns[i].bitangent;
 
+        // gram-schmidt, the sse vec kernels beat lazy expressions here(see the tbn benchmark)
         n = n.normalized();
         t = (t - t.dot(n) * n).normalized();
         b = (b - b.dot(n) * n - b.dot(t) * t).normalized();
-    }
+    });
 
     //if (loadparams.translatetoorigin)
     //{
@@ -254,6 +257,7 @@ model::model(std::vector<vertex> const& verts, std::vector<uint32> const& indice
         _materials.emplace_back(mat);
 }
 
-std::vector<instance_data> model::instancedata() const { return { instance_data{ matrix::Identity } }; }
+std::vector<instance_data> model::instancedata() const { return { instance_data{ stdx::matrix4x4::identity() } }; }
+std::pmr::vector<instance_data> model::instancedata(std::pmr::memory_resource* mem) const { return std::pmr::vector<instance_data>({ instance_data{ stdx::matrix4x4::identity() } }, mem); }
 
 }
\ No newline at end of file
@@ -34,6 +34,7 @@ struct model
 	std::vector<index> const& indices() const { return _indices; }
 	std::vector<uint32> const& materials() const { return _materials; }
 	std::vector<instance_data> instancedata() const;
+	std::pmr::vector<instance_data> instancedata(std::pmr::memory_resource* mem) const;
 
 	std::vector<index> _indices;
 	vertexattribs _vertices;
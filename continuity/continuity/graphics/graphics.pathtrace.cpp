@@ -81,7 +81,7 @@ void pathtracepass::operator()(deviceresources& devres)
     auto& globalres = globalresources::get();
 
     auto& cmdlist = devres.cmdlist;
-    auto const& pipelineobjects = globalres.psomap().find("pathtrace")->second;
+    auto const& pipelineobjects = *globalres.psomap().find("pathtrace")->second;
 
     cmdlist->SetComputeRootSignature(pipelineobjects.root_signature.Get());
     cmdlist->SetPipelineState1(pipelineobjects.pso_raytracing.Get());
@@ -128,7 +128,7 @@ void temporalaccumpass::operator()(deviceresources& devres)
     rt::accumparams& mappedparams = accumparamsbuffer[0];
     mappedparams.accumcount = accumcount++;
     auto& globalres = globalresources::get();
-    auto const& pipelineobjects = globalres.psomap().find("temporalaccum")->second;
+    auto const& pipelineobjects = *globalres.psomap().find("temporalaccum")->second;
 
     devres.cmdlist->SetComputeRootSignature(pipelineobjects.root_signature.Get());
     devres.cmdlist->SetPipelineState(pipelineobjects.pso.Get());
@@ -160,7 +160,7 @@ atrousdenoisepass::atrousdenoisepass(ptresources& ptres) : res(ptres)
 void atrousdenoisepass::operator()(deviceresources& devres)
 {
     auto& globalres = globalresources::get();
-    auto const& denoisepipeobjs = globalres.psomap().find("denoise")->second;
+    auto const& denoisepipeobjs = *globalres.psomap().find("denoise")->second;
 
     devres.cmdlist->SetPipelineState(denoisepipeobjs.pso.Get());
 
@@ -184,7 +184,7 @@ void atrousdenoisepass::operator()(deviceresources& devres)
         uavbarrierpass{ res.diffuseradiancetex[0], res.diffuseradiancetex[1], res.specularradiancetex[0], res.specularradiancetex[1] }(devres);
     }
 
-    auto const& postdenoisepipeobjs = globalres.psomap().find("postdenoise")->second;
+    auto const& postdenoisepipeobjs = *globalres.psomap().find("postdenoise")->second;
 
     // todo : filter moments and illumination bilaterally before denosing(for low accumulated samples)
     devres.cmdlist->SetPipelineState(postdenoisepipeobjs.pso.Get());
@@ -447,7 +447,7 @@ void renderer::postrender()
 void renderer::dispatchmesh(stdx::vecui3 dispatch, pipelinestate ps, std::vector<uint32> const& rootdescs)
 {
     auto& globalres = globalresources::get();
-    auto const psobjs = globalres.psomap().find(ps.psoname)->second;
+    auto const psobjs = *globalres.psomap().find(ps.psoname)->second;
 
     static constexpr uint32 dispatch1dlimit = 65536;
 
@@ -409,7 +409,7 @@ resourcelist texture<accesstype::gpu>::createfromfile(std::string const& path, b
     auto resource_transition = CD3DX12_RESOURCE_BARRIER::Transition(texture, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
     cmdlist->ResourceBarrier(1, &resource_transition);
 
-    auto const& pipelineobjects = globalres.psomap().find("genmipmaps")->second;
+    auto const& pipelineobjects = *globalres.psomap().find("genmipmaps")->second;
 
     struct genmipsparams
     {
@@ -168,18 +168,22 @@ struct structuredbuffer<t, accesstype::both> : public structuredbufferbase<t, up
 		uploadbuffer::create(nullptr, this->numelements * sizeof(t));
 	}
 
-	void create(std::vector<t> const& data)
+	// spans let data come from any contiguous container, like pmr vectors in frame memory
+	void create(std::span<t const> data)
 	{
 		this->numelements = uint32(data.size());
 		uploadbuffer::create(data.data(), this->numelements * sizeof(t));
 	}
 
-	void update(std::vector<t> const& data, std::size_t offset = 0)
+	void update(std::span<t const> data, std::size_t offset = 0)
 	{
 		stdx::cassert(data.size() <= this->numelements, "cannot update buffer with more data than initial size");
 		uploadbuffer::update(data.data(), offset * sizeof(t), uint32(data.size() * sizeof(t)));
 	}
 
+	void create(std::vector<t> const& data) { create(std::span<t const>(data)); }
+	void update(std::vector<t> const& data, std::size_t offset = 0) { update(std::span<t const>(data), offset); }
+
 	t& operator[](std::size_t idx) { stdx::cassert(this->mappeddata); return *(reinterpret_cast<t*>(this->mappeddata) + idx); }
 	t const& operator[](std::size_t idx) const { stdx::cassert(this->mappeddata); return *(reinterpret_cast<t*>(this->mappeddata) + idx); }
 };
@@ -228,7 +232,7 @@ struct dynamicbuffer
 		//_buffer = create_uploadbuffer(&_mappeddata, buffersize());
 	}
 
-	void updateresource(std::vector<t> const& data)
+	void updateresource(std::span<t const> data)
 	{
 		_count = data.size();
 		stdx::cassert(_count <= _maxcount);
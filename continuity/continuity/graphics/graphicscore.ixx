@@ -204,11 +204,12 @@ struct material
 
 struct instance_data
 {
-    matrix matx;
-    matrix normalmatx;
+    stdx::matrix4x4 matx;
+    stdx::matrix4x4 normalmatx;
 
     instance_data() = default;
-    instance_data(matrix const& m) : matx(m), normalmatx(m.Invert().Transpose()) {}
+    instance_data(stdx::matrix4x4 const& m) : matx(m), normalmatx(m.inverseaffine().transpose()) {}
+    instance_data(matrix const& m) : instance_data(utils::to_matrix4x4(m)) {}
 };
 
 struct light
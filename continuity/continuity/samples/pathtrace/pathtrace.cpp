@@ -14,17 +14,15 @@ module pathtrace;
 
 import stdx;
 import vec;
+import random;
 import std;
 import engineutils;
 import activesample;
 
 using matrix = DirectX::SimpleMath::Matrix;
 
-static std::random_device rd;
-static std::mt19937 re(rd());
-static std::uniform_real_distribution<float> distuf(0.f, 1.f);
-static std::uniform_real_distribution<float> distsf(-0.5f, 0.5f);
-static std::uniform_int_distribution<uint32> distu(0, std::numeric_limits<uint32>::max());
+// fixed seed, so frames are reproducible
+static stdx::xoshiro256 re;
 
 namespace sample_creator
 {
@@ -159,7 +157,7 @@ void pathtrace::render(float dt, gfx::renderer& renderer)
     scenedata.lightdir = lightdir;
     scenedata.lightluminance = 6;
     scenedata.frameidx = framecount;
-    scenedata.seed = distuf(re);
+    scenedata.seed = re.uniformf();
     scenedata.aoradius = 50;
     scenedata.enableao = 0;
     scenedata.envtex = renderer.environmenttex.ex();
@@ -169,9 +167,9 @@ void pathtrace::render(float dt, gfx::renderer& renderer)
     camviewinfo.viewpos = camera.GetCurrentPosition();
     camviewinfo.view = utils::to_matrix4x4(viewmat);
     camviewinfo.viewproj = utils::to_matrix4x4(viewproj);
-    camviewinfo.invviewproj = utils::to_matrix4x4(viewproj.Invert());
+    camviewinfo.invviewproj = camviewinfo.viewproj.inverse();
 
-    auto const jitter = stdx::vec2{ distsf(re), distsf(re) };
+    auto const jitter = stdx::vec2{ re.uniformf(-0.5f, 0.5f), re.uniformf(-0.5f, 0.5f) };
 
     // jitter is probably only needed if using taa
     camviewinfo.jitter = ptsettings.camjitter ? jitter : stdx::vec2{};
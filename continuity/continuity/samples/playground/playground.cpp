@@ -55,7 +55,8 @@ gfx::resourcelist playground::create_resources(gfx::renderer& renderer)
 void playground::update(float dt)
 {
     sample_base::update(dt);
-    for (auto b : stdx::makejoin<gfx::bodyinterface>(models)) b->update(dt);
+    // serial, body updates write to frame memory
+    stdx::makejoin<gfx::bodyinterface>(models).for_each([dt](gfx::bodyinterface& b) { b.update(dt); });
 }
 
 void playground::render(float dt, gfx::renderer& renderer)
@@ -91,8 +92,8 @@ void playground::render(float dt, gfx::renderer& renderer)
     viewglobalsbuffer.update({ camviewinfo, lightviewinfo });
     sceneglobalsbuffer.update({ scenedata });
 
-    auto const shadowpipelineobjs = globalres.psomap().find("instanced_depthonly")->second;
-    auto const mainpipelineobjs = globalres.psomap().find("instanced")->second;
+    auto const shadowpipelineobjs = *globalres.psomap().find("instanced_depthonly")->second;
+    auto const mainpipelineobjs = *globalres.psomap().find("instanced")->second;
 
     auto rthandle = renderer.rtheap.cpuhandle(renderer.rtview.heapidx);
     auto dthandle = renderer.dtheap.cpuhandle(renderer.dtview.heapidx);
@@ -144,7 +144,7 @@ void raytrace::render(float dt, gfx::renderer& renderer)
     //framecbuffer.inv_viewproj = utils::to_matrix4x4((globalres.view().view * globalres.view().proj).Invert());
 
     auto& cmdlist = renderer.deviceres().cmdlist;
-    auto const& pipelineobjects = globalres.psomap().find("raytrace")->second;
+    auto const& pipelineobjects = *globalres.psomap().find("raytrace")->second;
 
     // bind the global root signature, heaps and frame index, other resources are bindless 
     cmdlist->SetDescriptorHeaps(1, globalres.resourceheap().d3dheap.GetAddressOf());
@@ -162,7 +162,7 @@ gfx::resourcelist sphgpu::create_resources(gfx::renderer& renderer)
         rootconstants.containerorigin[0] = rootconstants.containerorigin[1] = rootconstants.containerorigin[2] = 0.0f;
         rootconstants.containerextents[0] = rootconstants.containerextents[1] = rootconstants.containerextents[2] = roomextents;
 
-        auto const& pipelineobjects = globalres.psomap().find("sphgpuinit")->second;
+        auto const& pipelineobjects = *globalres.psomap().find("sphgpuinit")->second;
         auto& cmdlist = *renderer.deviceres().cmdlist.Get();
         cmdlist.SetPipelineState(pipelineobjects.pso.Get());
         cmdlist.SetComputeRootSignature(pipelineobjects.root_signature.Get());
@@ -342,7 +342,7 @@ void sphgpu::render(float dt, gfx::renderer& renderer)
     // todo : use timestep from courant condition, but this might be tricky in gpu implementation
     // sim passes
     {
-        auto const& pipelineobjects = globalres.psomap().find("sphgpudensitypressure")->second;
+        auto const& pipelineobjects = *globalres.psomap().find("sphgpudensitypressure")->second;
 
         // root signature is same for sim shaders
         cmdlist.SetComputeRootSignature(pipelineobjects.root_signature.Get());
@@ -361,7 +361,7 @@ void sphgpu::render(float dt, gfx::renderer& renderer)
 
         // acceleration, velocity and position
         {
-            auto const& pipelineobjects = globalres.psomap().find("sphgpuposition")->second;
+            auto const& pipelineobjects = *globalres.psomap().find("sphgpuposition")->second;
 
             cmdlist.SetPipelineState(pipelineobjects.pso.Get());
 
@@ -397,7 +397,7 @@ void sphgpu::render(float dt, gfx::renderer& renderer)
     //framecbuffer.campos = camera.GetCurrentPosition();
     //framecbuffer.inv_viewproj = utils::to_matrix4x4((globalres.view().view * globalres.view().proj).Invert());
 
-    auto const& pipelineobjects = globalres.psomap().find("sph_render")->second;
+    auto const& pipelineobjects = *globalres.psomap().find("sph_render")->second;
 
     // bind the global root signature, heaps and frame index, other resources are bindless
     cmdlist.SetDescriptorHeaps(1, globalres.resourceheap().d3dheap.GetAddressOf());
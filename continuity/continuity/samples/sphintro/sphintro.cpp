@@ -6,6 +6,9 @@ module sphintro;
 
 import stdx;
 import vec;
+import jobs;
+import random;
+import flathash;
 import std;
 
 namespace sample_creator
@@ -19,8 +22,8 @@ std::unique_ptr<sample_base> create_instance<samples::sphintro>(view_data const&
 
 }
 
-std::random_device rd;
-static std::mt19937 re(rd());
+// fixed seed, so runs are reproducible
+static stdx::xoshiro256 re;
 
 using namespace DirectX;
 
@@ -438,7 +441,7 @@ int polygonize(mcgridcell grid, float isolevel, mctriangle* triangles)
 
 std::vector<stdx::vec3> fillwithspheres(geometry::aabb const& box, uint count, float radius)
 {
-    std::unordered_set<uint> occupied;
+    stdx::flathashset<uint> occupied;
     std::vector<stdx::vec3> spheres;
 
     // todo : tolerance with fold expressions for container types
@@ -463,10 +466,8 @@ std::vector<stdx::vec3> fillwithspheres(geometry::aabb const& box, uint count, f
     auto const gridorigin = box.center() - stdx::vec3::filled(cubelen / 2.f) + stdx::vec3{ 0.0f, -0.5f, 0.0f };
     for (auto i : stdx::range(count))
     {
-        static std::uniform_int_distribution<uint> distvoxel(0u, numcells - 1);
-
         uint emptycell = 0;
-        while (occupied.find(emptycell) != occupied.end()) emptycell = distvoxel(re);
+        while (occupied.find(emptycell) != occupied.end()) emptycell = re.uniform(static_cast<uint32>(numcells));
 
         occupied.insert(emptycell);
 
@@ -503,12 +504,8 @@ sphfluid::sphfluid(geometry::aabb const& _bounds) : container(_bounds)
     //auto const& redmaterial = gfx::globalresources::get().mat("ball");
     particleparams.reserve(numparticles);
     
-    static std::uniform_real_distribution<float> distvel(-0.1f, 0.1f);
-    static std::uniform_real_distribution<float> distacc(-0.1f, 0.1f);
-
     auto const intialhalfspan = _bounds.span() / (2.0f);
     geometry::aabb initial_bounds = { _bounds.center() - intialhalfspan, _bounds.center() + intialhalfspan };
-
     //geometry::aabb initial_bounds = { vector3(-2.0f), vector3(2.0f) };
     for (auto const& center : fillwithspheres(initial_bounds, numparticles, particleradius))
     {
@@ -524,8 +521,8 @@ sphfluid::sphfluid(geometry::aabb const& _bounds) : container(_bounds)
 
         particleparams.back().v = particleparams.back().a = vector3::Zero;
         // give small random acceleration and velocity to particles
-        //particleparams.back().v = vector3(distvel(re), distvel(re), distvel(re));
-        //particleparams.back().a = vector3(distacc(re), distacc(re), distacc(re));
+        //particleparams.back().v = vector3(re.uniformf(-0.1f, 0.1f), re.uniformf(-0.1f, 0.1f), re.uniformf(-0.1f, 0.1f));
+        //particleparams.back().a = vector3(re.uniformf(-0.1f, 0.1f), re.uniformf(-0.1f, 0.1f), re.uniformf(-0.1f, 0.1f));
 
         // compute velocity at -half time step
         particleparams.back().vp = particleparams.back().v - (0.5f * fixedtimestep) * particleparams.back().a;
@@ -582,14 +579,28 @@ std::vector<uint32> const& sphfluid::indices() const
     return fluidsurfaceindices;
 }
 
-std::vector<gfx::instance_data> sphfluid::instancedata() const
+template<typename params_t, typename container_t>
+void fillinstancedata(params_t const& particleparams, container_t& particles_instancedata)
 {
-    std::vector<gfx::instance_data> particles_instancedata;
+    particles_instancedata.reserve(particleparams.size());
     for (auto const& particleparam : particleparams)
     {
-        particles_instancedata.emplace_back(matrix::CreateTranslation(particleparam.p));
+        particles_instancedata.emplace_back(stdx::matrix4x4::translation({ particleparam.p.x, particleparam.p.y, particleparam.p.z }));
     }
+}
+
+std::vector<gfx::instance_data> sphfluid::instancedata() const
+{
+    std::vector<gfx::instance_data> particles_instancedata;
+    fillinstancedata(particleparams, particles_instancedata);
+    return particles_instancedata;
+}
 
+// rebuilt every frame, so it can live in frame memory
+std::pmr::vector<gfx::instance_data> sphfluid::instancedata(std::pmr::memory_resource* mem) const
+{
+    std::pmr::vector<gfx::instance_data> particles_instancedata(mem);
+    fillinstancedata(particleparams, particles_instancedata);
     return particles_instancedata;
 }
 
@@ -663,10 +674,11 @@ void sphfluid::update(float dt)
         //remainingtime -= timestep;
 
         // compute pressure and densities
-        for (auto& particleparam : particleparams)
+        stdx::parallel_for(stdx::range(particleparams.size()), [&](uint i)
         {
+            auto& particleparam = particleparams[i];
             particleparam.rho = 0.0f;
-            for (auto neighbourparam : particleparams)
+            for (auto const& neighbourparam : particleparams)
             {
                 float const distsqr = vector3::DistanceSquared(particleparam.p, neighbourparam.p);
 
@@ -680,15 +692,17 @@ void sphfluid::update(float dt)
             // prevent density smaller than reference density to avoid negative pressure
             particleparam.rho = std::max(particleparam.rho, rho0);
             particleparam.pr = k * (particleparam.rho - rho0);
-        }
+        });
         
         static constexpr float repulsion_force = 1.0f;
         auto const& containercenter = container.center();
         auto const& halfextents = container.span() / 2.0f;
 
         // compute acceleration
-        for (auto& particleparam : particleparams)
+        // all accelerations are computed before any particle moves, so particles can be processed in parallel
+        stdx::parallel_for(stdx::range(particleparams.size()), [&](uint i)
         {
+            auto& particleparam = particleparams[i];
             auto const& v = particleparam.v;
             auto const& rho = particleparam.rho;
             auto const& pr = particleparam.pr;
@@ -723,6 +737,11 @@ void sphfluid::update(float dt)
 
             // add gravity
             particleparam.a += vector3(0.0f, -2.0f, 0.0f);
+        });
+
+        stdx::parallel_for(stdx::range(particleparams.size()), [&](uint i)
+        {
+            auto& particleparam = particleparams[i];
 
             // collisions(just reflect velocity) and leap frog integration
             {
@@ -771,7 +790,7 @@ void sphfluid::update(float dt)
                 particleparam.p += particleparam.vp * timestep;
                 particleparam.v = particleparam.vp + particleparam.a * (0.5f * timestep);
             }
-        }
+        });
     }
 
     //fluidsurface.clear();
@@ -782,11 +801,9 @@ void sphfluid::update(float dt)
     // assume container it is a cube
     auto container_len = container.span()[0];
     auto nummarches_perdim = stdx::ceil(container_len / marchingcube_size) + 2;
-    auto nummarches = nummarches_perdim * nummarches_perdim * nummarches_perdim;
     auto offset = container.min_pt - stdx::vec3::filled(marchingcube_size);
-    for (uint i = 0; i < nummarches; ++i)
+    stdx::parallel_for(stdx::grididx<2>(stdx::vec<3, uint>::filled(nummarches_perdim)), [&](stdx::grididx<2> const& cell)
     {
-        auto const cell = stdx::grididx<2>::from1d(nummarches_perdim - 1u, i);
         mcgridcell gridcell;
 
         // the vertices should be sorted to form a rectangular contour
@@ -851,7 +868,7 @@ void sphfluid::update(float dt)
                 // todo : populate fluidsurfaceindices
             }
         }
-    }
+    });
 }
 
 sphfluidintro::sphfluidintro(view_data const& viewdata) : sample_base(viewdata)
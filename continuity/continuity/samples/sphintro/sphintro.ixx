@@ -58,6 +58,7 @@ public:
 	std::vector<gfx::vertex> vertices() const;
 	std::vector<uint32> const& indices() const;
 	std::vector<gfx::instance_data> instancedata() const;
+	std::pmr::vector<gfx::instance_data> instancedata(std::pmr::memory_resource* mem) const;
 	std::vector<gfx::vertex> particlevertices() const;
 	void update(float dt);
 	std::vector<gfx::vertex> fluidsurface;
@@ -0,0 +1,367 @@
+module;
+
+#include <immintrin.h>
+
+export module flathash;
+
+import stdxcore;
+import stdx;
+import vec;
+import std;
+
+export namespace stdx
+{
+
+// defaults to std::hash, specialized for the stdx types used as keys
+template<typename t>
+struct hash : std::hash<t> {};
+
+constexpr uint hashcombine(uint seed, uint h) { return seed ^ (h + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2)); }
+
+template<uint d, typename t>
+struct hash<vec<d, t>>
+{
+	uint operator()(vec<d, t> const& v) const
+	{
+		uint r = 0;
+		for (auto const& c : v)
+			r = hashcombine(r, std::hash<t>{}(c));
+		return r;
+	}
+};
+
+template<uint n>
+struct hash<grididx<n>> : hash<vec<n + 1, uint>> {};
+
+// open addressing hash table with a separate array of control bytes (swiss table)
+// control bytes are probed 16 at a time with sse2, and only slots whose 7 bit hash tag matches get compared
+// slots are contiguous, so lookups and iteration touch far fewer cache lines than node based containers
+// pointers and iterators are invalidated by inserts that grow the table
+template<typename key_t, typename value_t, typename hash_t, typename eq_t>
+class flathashtable
+{
+	using ctrl_t = std::int8_t;
+
+	static constexpr ctrl_t emptyslot = -128;
+	static constexpr ctrl_t deletedslot = -2;
+	static constexpr uint groupwidth = 16;
+	static constexpr uint mincapacity = groupwidth;
+
+	static constexpr bool isset = std::is_same_v<key_t, value_t>;
+
+	template<bool isconst>
+	class iter
+	{
+		using table_t = std::conditional_t<isconst, flathashtable const, flathashtable>;
+
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = value_t;
+		using difference_type = std::ptrdiff_t;
+		using pointer = std::conditional_t<isconst, value_t const*, value_t*>;
+		using reference = std::conditional_t<isconst, value_t const&, value_t&>;
+
+		iter() = default;
+		iter(table_t* _table, uint _idx) : table(_table), idx(_idx) { skipfree(); }
+		operator iter<true>() const requires(!isconst) { return { table, idx }; }
+
+		reference operator*() const { return table->slots[idx]; }
+		pointer operator->() const { return table->slots + idx; }
+		iter& operator++() { ++idx; skipfree(); return *this; }
+		iter operator++(int) { auto r = *this; ++(*this); return r; }
+		bool operator==(iter const& r) const { return idx == r.idx; }
+
+	private:
+		friend class flathashtable;
+
+		void skipfree() { while (idx < table->capacity && table->ctrl[idx] < 0) ++idx; }
+
+		table_t* table = nullptr;
+		uint idx = 0;
+	};
+
+public:
+	using key_type = key_t;
+	using value_type = value_t;
+	using size_type = uint;
+	using hasher = hash_t;
+	using key_equal = eq_t;
+	using iterator = iter<isset>;
+	using const_iterator = iter<true>;
+
+	flathashtable() = default;
+	flathashtable(std::initializer_list<value_t> values) { reserve(values.size()); for (auto const& v : values) insert(v); }
+	flathashtable(flathashtable const& other) { reserve(other.size()); for (auto const& v : other) insert(v); }
+	flathashtable(flathashtable&& other) noexcept { swap(other); }
+	flathashtable& operator=(flathashtable other) noexcept { swap(other); return *this; }
+	~flathashtable() { destroy(); }
+
+	iterator begin() { return { this, 0 }; }
+	iterator end() { return { this, capacity }; }
+	const_iterator begin() const { return { this, 0 }; }
+	const_iterator end() const { return { this, capacity }; }
+	const_iterator cbegin() const { return begin(); }
+	const_iterator cend() const { return end(); }
+
+	uint size() const { return numelements; }
+	bool empty() const { return numelements == 0; }
+
+	iterator find(key_t const& key) { return { this, findindex(key) }; }
+	const_iterator find(key_t const& key) const { return { this, findindex(key) }; }
+	bool contains(key_t const& key) const { return findindex(key) != capacity; }
+	uint count(key_t const& key) const { return contains(key) ? 1 : 0; }
+
+	std::pair<iterator, bool> insert(value_t const& value) { return emplace(value); }
+	std::pair<iterator, bool> insert(value_t&& value) { return emplace(std::move(value)); }
+
+	template<typename ... args_t>
+	std::pair<iterator, bool> emplace(args_t&& ... args)
+	{
+		// the key has to be known before probing, so the value is built up front
+		value_t value(std::forward<args_t>(args)...);
+		auto const [idx, inserted] = findorprepare(keyof(value));
+		if (inserted)
+			std::construct_at(slots + idx, std::move(value));
+
+		return { { this, idx }, inserted };
+	}
+
+	uint erase(key_t const& key)
+	{
+		uint const idx = findindex(key);
+		if (idx == capacity)
+			return 0;
+
+		eraseat(idx);
+		return 1;
+	}
+
+	iterator erase(const_iterator it)
+	{
+		eraseat(it.idx);
+		return { this, it.idx + 1 };
+	}
+
+	void clear()
+	{
+		destroyslots();
+		std::fill(ctrl.begin(), ctrl.end(), emptyslot);
+		numelements = 0;
+		numdeleted = 0;
+	}
+
+	void reserve(uint count)
+	{
+		uint const needed = capacityfor(count);
+		if (needed > capacity)
+			rehash(needed);
+	}
+
+	void swap(flathashtable& other) noexcept
+	{
+		std::swap(ctrl, other.ctrl);
+		std::swap(slots, other.slots);
+		std::swap(capacity, other.capacity);
+		std::swap(numelements, other.numelements);
+		std::swap(numdeleted, other.numdeleted);
+	}
+
+protected:
+	static key_t const& keyof(value_t const& v)
+	{
+		if constexpr (isset)
+			return v;
+		else
+			return v.first;
+	}
+
+	// returns the slot of the key and whether it's empty and waiting to be constructed
+	std::pair<uint, bool> findorprepare(key_t const& key)
+	{
+		uint const h = hashof(key);
+		if (uint const idx = findindex(key, h); idx != capacity)
+			return { idx, false };
+
+		// tombstones count towards the load, so a table with many erases is cleaned up here too
+		if (numelements + numdeleted + 1 > maxload(capacity))
+			rehash(std::max(capacityfor(numelements + 1), capacity));
+
+		uint const idx = findfree(h);
+		numdeleted -= ctrl[idx] == deletedslot ? 1 : 0;
+		setctrl(idx, tag(h));
+		++numelements;
+		return { idx, true };
+	}
+
+	value_t* slots = nullptr;
+
+private:
+	// std::hash of integers is the identity on some implementations, mix so the tag and the position use different bits
+	static uint hashof(key_t const& key)
+	{
+		uint64 h = static_cast<uint64>(hash_t{}(key));
+		h ^= h >> 33;
+		h *= 0xff51afd7ed558ccdull;
+		h ^= h >> 33;
+		return static_cast<uint>(h);
+	}
+
+	static ctrl_t tag(uint h) { return static_cast<ctrl_t>(h & 0x7f); }
+	static uint maxload(uint cap) { return cap - cap / 8; }
+	static uint capacityfor(uint count) { return count == 0 ? 0 : std::bit_ceil(std::max(mincapacity, count + count / 7 + 1)); }
+
+	uint mask() const { return capacity - 1; }
+
+	// groups start anywhere, the first groupwidth - 1 control bytes are mirrored past the end so a load never wraps
+	__m128i loadgroup(uint pos) const { return _mm_loadu_si128(reinterpret_cast<__m128i const*>(ctrl.data() + pos)); }
+
+	void setctrl(uint idx, ctrl_t c)
+	{
+		ctrl[idx] = c;
+		ctrl[((idx - (groupwidth - 1)) & mask()) + (groupwidth - 1)] = c;
+	}
+
+	uint findindex(key_t const& key) const { return findindex(key, hashof(key)); }
+
+	uint findindex(key_t const& key, uint h) const
+	{
+		if (capacity == 0)
+			return capacity;
+
+		auto const tagmask = _mm_set1_epi8(tag(h));
+		auto const emptymask = _mm_set1_epi8(emptyslot);
+
+		// triangular probing over groups visits every group once when capacity is a power of two
+		uint pos = (h >> 7) & mask();
+		for (uint probe(groupwidth); ; probe += groupwidth)
+		{
+			auto const group = loadgroup(pos);
+			for (uint match = _mm_movemask_epi8(_mm_cmpeq_epi8(group, tagmask)); match != 0; match &= match - 1)
+			{
+				uint const idx = (pos + std::countr_zero(match)) & mask();
+				if (eq_t{}(keyof(slots[idx]), key))
+					return idx;
+			}
+
+			// an empty control byte ends the probe sequence of every key that hashes here
+			if (_mm_movemask_epi8(_mm_cmpeq_epi8(group, emptymask)) != 0)
+				return capacity;
+
+			pos = (pos + probe) & mask();
+		}
+	}
+
+	// first empty or deleted slot in the probe sequence, the sign bit is set only for those
+	uint findfree(uint h) const
+	{
+		uint pos = (h >> 7) & mask();
+		for (uint probe(groupwidth); ; probe += groupwidth)
+		{
+			if (uint const free = _mm_movemask_epi8(loadgroup(pos)); free != 0)
+				return (pos + std::countr_zero(free)) & mask();
+
+			pos = (pos + probe) & mask();
+		}
+	}
+
+	void eraseat(uint idx)
+	{
+		std::destroy_at(slots + idx);
+		setctrl(idx, deletedslot);
+		--numelements;
+		++numdeleted;
+	}
+
+	void rehash(uint newcapacity)
+	{
+		auto oldctrl = std::move(ctrl);
+		auto const oldslots = slots;
+		uint const oldcapacity = capacity;
+
+		capacity = newcapacity;
+		ctrl.assign(capacity + groupwidth - 1, emptyslot);
+		slots = std::allocator<value_t>{}.allocate(capacity);
+		numdeleted = 0;
+
+		for (uint i(0); i < oldcapacity; ++i)
+		{
+			if (oldctrl[i] < 0)
+				continue;
+
+			uint const h = hashof(keyof(oldslots[i]));
+			uint const idx = findfree(h);
+			setctrl(idx, tag(h));
+			std::construct_at(slots + idx, std::move(oldslots[i]));
+			std::destroy_at(oldslots + i);
+		}
+
+		if (oldslots)
+			std::allocator<value_t>{}.deallocate(oldslots, oldcapacity);
+	}
+
+	void destroyslots()
+	{
+		if constexpr (!std::is_trivially_destructible_v<value_t>)
+		{
+			for (uint i(0); i < capacity; ++i)
+				if (ctrl[i] >= 0)
+					std::destroy_at(slots + i);
+		}
+	}
+
+	void destroy()
+	{
+		destroyslots();
+		if (slots)
+			std::allocator<value_t>{}.deallocate(slots, capacity);
+	}
+
+	std::vector<ctrl_t> ctrl;
+	uint capacity = 0;
+	uint numelements = 0;
+	uint numdeleted = 0;
+};
+
+// keys can't be modified through iterators of the set
+template<typename key_t, typename hash_t = stdx::hash<key_t>, typename eq_t = std::equal_to<key_t>>
+using flathashset = flathashtable<key_t, key_t, hash_t, eq_t>;
+
+// entries are std::pair<key_t, mapped_t>, the key must not be modified through iterators
+template<typename key_t, typename mapped_t, typename hash_t = stdx::hash<key_t>, typename eq_t = std::equal_to<key_t>>
+class flathashmap : public flathashtable<key_t, std::pair<key_t, mapped_t>, hash_t, eq_t>
+{
+	using base_t = flathashtable<key_t, std::pair<key_t, mapped_t>, hash_t, eq_t>;
+
+public:
+	using mapped_type = mapped_t;
+	using base_t::base_t;
+
+	// the mapped value is only constructed if the key is new
+	template<typename ... args_t>
+	std::pair<typename base_t::iterator, bool> try_emplace(key_t const& key, args_t&& ... args)
+	{
+		auto const [idx, inserted] = this->findorprepare(key);
+		if (inserted)
+			std::construct_at(this->slots + idx, std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<args_t>(args)...));
+
+		return { { this, idx }, inserted };
+	}
+
+	mapped_t& operator[](key_t const& key) { return try_emplace(key).first->second; }
+
+	mapped_t& at(key_t const& key)
+	{
+		auto const it = this->find(key);
+		stdx::cassert(it != this->end(), "key not found");
+		return it->second;
+	}
+
+	mapped_t const& at(key_t const& key) const
+	{
+		auto const it = this->find(key);
+		stdx::cassert(it != this->end(), "key not found");
+		return it->second;
+	}
+};
+
+}
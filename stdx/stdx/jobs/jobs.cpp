@@ -0,0 +1,168 @@
+module jobs;
+
+namespace stdx
+{
+
+// system and queue owned by this thread, null for threads that aren't workers
+thread_local jobsystem const* workersystem = nullptr;
+thread_local uint workerqueue = 0;
+
+jobsystem::jobsystem(uint numworkers)
+{
+	for (uint i(0); i <= numworkers; ++i)
+		queues.emplace_back(std::make_unique<queue>());
+
+	for (uint i(1); i <= numworkers; ++i)
+		workers.emplace_back([this, i]() { workerloop(i); });
+}
+
+jobsystem::~jobsystem()
+{
+	stop.store(true);
+
+	// wake up sleeping workers so they can see the stop flag
+	queued.fetch_add(1);
+	queued.notify_all();
+
+	for (auto& w : workers)
+		w.join();
+}
+
+jobsystem& jobsystem::get()
+{
+	static jobsystem system(std::max(std::thread::hardware_concurrency(), 2u) - 1);
+	return system;
+}
+
+void jobsystem::limitthreads(uint count)
+{
+	maxthreads.store(count == 0 ? std::numeric_limits<uint>::max() : count, std::memory_order_relaxed);
+}
+
+void jobsystem::submit(jobgroup& group, job_t job)
+{
+	group.pending.fetch_add(1, std::memory_order_relaxed);
+
+	{
+		auto& q = *queues[ownqueue()];
+		std::scoped_lock lock(q.mutex);
+		q.entries.push_back({ std::move(job), &group });
+	}
+
+	queued.fetch_add(1, std::memory_order_release);
+	queued.notify_one();
+}
+
+void jobsystem::wait(jobgroup& group)
+{
+	while (!group.done())
+	{
+		if (!runone(ownqueue()))
+			std::this_thread::yield();
+	}
+}
+
+uint jobsystem::chunkcount(uint count, uint grain) const
+{
+	// a few chunks per thread leaves room for stealing when chunks take uneven time
+	static constexpr uint chunksperthread = 4;
+
+	if (grain == 0)
+		grain = std::max<uint>(1, count / (numthreads() * chunksperthread));
+
+	return (count + grain - 1) / grain;
+}
+
+void jobsystem::forchunks(uint count, uint grain, chunkbody_t const& body)
+{
+	uint const numchunks = chunkcount(count, grain);
+	if (numchunks == 0)
+		return;
+
+	uint const chunksize = (count + numchunks - 1) / numchunks;
+	if (numchunks == 1 || numthreads() == 1)
+	{
+		for (uint c(0); c < numchunks; ++c)
+			body(c, c * chunksize, std::min(count, (c + 1) * chunksize));
+		return;
+	}
+
+	jobgroup group;
+	for (uint c(1); c < numchunks; ++c)
+		submit(group, [&body, c, chunksize, count]() { body(c, c * chunksize, std::min(count, (c + 1) * chunksize)); });
+
+	// run the first chunk on this thread, then help with the rest
+	body(0, 0, std::min(count, chunksize));
+	wait(group);
+}
+
+bool jobsystem::runone(uint self)
+{
+	entry e;
+	bool found = false;
+
+	// own jobs are taken from the back, they were pushed last and are likely to be in cache
+	{
+		auto& q = *queues[self];
+		std::scoped_lock lock(q.mutex);
+		if (!q.entries.empty())
+		{
+			e = std::move(q.entries.back());
+			q.entries.pop_back();
+			found = true;
+		}
+	}
+
+	// steal the oldest job of another queue, they tend to be the biggest
+	for (uint i(1); !found && i < queues.size(); ++i)
+	{
+		auto& q = *queues[(self + i) % queues.size()];
+		std::scoped_lock lock(q.mutex);
+		if (!q.entries.empty())
+		{
+			e = std::move(q.entries.front());
+			q.entries.pop_front();
+			found = true;
+		}
+	}
+
+	if (!found)
+		return false;
+
+	queued.fetch_sub(1, std::memory_order_relaxed);
+	e.job();
+	e.group->pending.fetch_sub(1, std::memory_order_release);
+	return true;
+}
+
+uint jobsystem::ownqueue() const
+{
+	return workersystem == this ? workerqueue : 0;
+}
+
+void jobsystem::workerloop(uint self)
+{
+	workersystem = this;
+	workerqueue = self;
+	while (!stop.load(std::memory_order_relaxed))
+	{
+		// capped workers poll rarely instead of sleeping on queued, which the active threads keep changing
+		if (self >= maxthreads.load(std::memory_order_relaxed))
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			continue;
+		}
+
+		if (runone(self))
+			continue;
+
+		// sleep until something is queued, wait returns right away if a job was queued after the load
+		uint const numqueued = queued.load(std::memory_order_acquire);
+		if (numqueued == 0)
+			queued.wait(0);
+		else
+			std::this_thread::yield();
+	}
+}
+
+}
@@ -0,0 +1,146 @@
+export module jobs;
+
+import stdxcore;
+import stdx;
+import vec;
+import std;
+
+export namespace stdx
+{
+
+// counts the outstanding jobs of a group
+struct jobgroup
+{
+	std::atomic<uint> pending = 0;
+
+	bool done() const { return pending.load(std::memory_order_acquire) == 0; }
+};
+
+// work stealing job system
+// every worker owns a deque, it pushes and pops at the back while idle threads steal from the front
+// threads waiting on a group run queued jobs instead of blocking, so jobs can spawn and wait on nested jobs
+class jobsystem
+{
+public:
+	using job_t = std::function<void()>;
+
+	// body of a chunked loop, gets the chunk index and the [begin, end) range of the chunk
+	using chunkbody_t = std::function<void(uint, uint, uint)>;
+
+	explicit jobsystem(uint numworkers);
+	~jobsystem();
+
+	jobsystem(jobsystem const&) = delete;
+	jobsystem& operator=(jobsystem const&) = delete;
+
+	// created on first use with a worker per hardware thread, the calling thread makes up the last one
+	static jobsystem& get();
+
+	// threads that run jobs, all of them unless limitthreads capped it
+	uint numthreads() const { return std::min<uint>(workers.size() + 1, maxthreads.load(std::memory_order_relaxed)); }
+
+	// workers past the first count - 1 stop taking jobs until the cap is raised again, for measuring how work scales
+	// 0 lifts the cap
+	void limitthreads(uint count);
+
+	void submit(jobgroup& group, job_t job);
+	void wait(jobgroup& group);
+
+	// splits [0, count) in chunks of at least grain elements and waits for all of them
+	// grain of 0 picks a few chunks per thread, returns the number of chunks
+	uint chunkcount(uint count, uint grain) const;
+	void forchunks(uint count, uint grain, chunkbody_t const& body);
+
+private:
+	struct entry
+	{
+		job_t job;
+		jobgroup* group = nullptr;
+	};
+
+	// queue 0 takes jobs submitted from threads outside of the system
+	struct queue
+	{
+		std::mutex mutex;
+		std::deque<entry> entries;
+	};
+
+	uint ownqueue() const;
+	bool runone(uint self);
+	void workerloop(uint self);
+
+	std::vector<std::unique_ptr<queue>> queues;
+	std::vector<std::thread> workers;
+	std::atomic<uint> queued = 0;
+	std::atomic<uint> maxthreads = std::numeric_limits<uint>::max();
+	std::atomic<bool> stop = false;
+};
+
+template<std::integral t, typename f_t>
+requires std::invocable<f_t const&, t>
+void parallel_for(std::ranges::iota_view<t, t> r, f_t const& f, uint grain = 0)
+{
+	t const first = *r.begin();
+	jobsystem::get().forchunks(static_cast<uint>(r.size()), grain, [&](uint, uint b, uint e) { for (uint i(b); i < e; ++i) f(static_cast<t>(first + i)); });
+}
+
+// visits every index in [0, extents), idx[0] changes fastest
+// only the first index of a chunk is decoded, the rest are stepped
+template<uint n, typename f_t>
+requires std::invocable<f_t const&, grididx<n> const&>
+void parallel_for(grididx<n> const& extents, f_t const& f, uint grain = 0)
+{
+	uint count = 1;
+	for (auto e : extents) count *= e;
+
+	jobsystem::get().forchunks(count, grain, [&](uint, uint b, uint e)
+	{
+		grididx<n> idx;
+		for (uint i(0), rem(b); i <= n; ++i) { idx[i] = rem % extents[i]; rem /= extents[i]; }
+
+		for (uint i(b); i < e; ++i)
+		{
+			f(idx);
+			for (uint j(0); j <= n && ++idx[j] == extents[j]; ++j) idx[j] = 0;
+		}
+	});
+}
+
+// visits the elements of a join in chunks that may cross containers, f gets a span of concrete elements
+template<typename t, typename... args_t, typename f_t>
+requires join<t, args_t...>::contiguous
+void parallel_visit(join<t, args_t...>& j, f_t const& f, uint grain = 0)
+{
+	jobsystem::get().forchunks(j.size(), grain, [&](uint, uint b, uint e) { j.visit(b, e, f); });
+}
+
+template<typename t, typename... args_t, typename f_t>
+requires join<t, args_t...>::contiguous && std::invocable<f_t const&, t&>
+void parallel_for_each(join<t, args_t...>& j, f_t const& f, uint grain = 0)
+{
+	parallel_visit(j, [&](auto elems) { for (auto& e : elems) f(static_cast<t&>(e)); }, grain);
+}
+
+// reduces map(i) over the range, partial results of chunks are combined in order so the result doesn't depend on scheduling
+template<std::integral i_t, typename t, typename map_t, typename reduce_t>
+requires std::invocable<map_t const&, i_t> && std::invocable<reduce_t const&, t, t>
+t parallel_reduce(std::ranges::iota_view<i_t, i_t> r, t identity, map_t const& map, reduce_t const& reduce, uint grain = 0)
+{
+	auto& system = jobsystem::get();
+	uint const count = static_cast<uint>(r.size());
+	i_t const first = *r.begin();
+
+	std::vector<t> partials(system.chunkcount(count, grain), identity);
+	system.forchunks(count, grain, [&](uint chunk, uint b, uint e)
+	{
+		t acc = identity;
+		for (uint i(b); i < e; ++i) acc = reduce(acc, map(static_cast<i_t>(first + i)));
+		partials[chunk] = acc;
+	});
+
+	t res = identity;
+	for (auto const& p : partials) res = reduce(res, p);
+	return res;
+}
+
+}
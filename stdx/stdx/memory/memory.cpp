@@ -0,0 +1,151 @@
+module memory;
+
+namespace stdx
+{
+
+heapcounter& heapcounter::get()
+{
+	// constant initialized, so operator new can count allocations made before main
+	static constinit heapcounter counter;
+	return counter;
+}
+
+countingresource& countingresource::get()
+{
+	static countingresource counter;
+	return counter;
+}
+
+void* countingresource::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+	numallocations.fetch_add(1, std::memory_order_relaxed);
+	numbytes.fetch_add(bytes, std::memory_order_relaxed);
+	return upstream->allocate(bytes, alignment);
+}
+
+framearena::framearena(uint initialsize, std::pmr::memory_resource* _upstream) : upstream(_upstream)
+{
+	addblock(std::max<uint>(initialsize, 1));
+}
+
+framearena::~framearena()
+{
+	releaseblocks();
+}
+
+framearena& framearena::get()
+{
+	// the counter is constructed first, so it outlives the arena
+	static framearena arena(1 << 20, &countingresource::get());
+	return arena;
+}
+
+void framearena::reset()
+{
+	if (blocks.size() > 1)
+	{
+		uint const total = capacity();
+		releaseblocks();
+		addblock(total);
+	}
+
+	current = 0;
+	offset = 0;
+	usedbytes = 0;
+}
+
+uint framearena::capacity() const
+{
+	uint res = 0;
+	for (auto const& b : blocks) res += b.size;
+	return res;
+}
+
+void* framearena::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+	for (;;)
+	{
+		auto const& b = blocks[current];
+		uint const aligned = (reinterpret_cast<uint>(b.data + offset) + alignment - 1) & ~(alignment - 1);
+		uint const start = aligned - reinterpret_cast<uint>(b.data);
+		if (start + bytes <= b.size)
+		{
+			offset = start + bytes;
+			usedbytes += bytes;
+			return b.data + start;
+		}
+
+		// grow geometrically, so a frame needs a handful of blocks at most
+		if (current + 1 == blocks.size())
+			addblock(std::max<uint>(b.size * 2, bytes + alignment));
+
+		++current;
+		offset = 0;
+	}
+}
+
+void framearena::addblock(uint size)
+{
+	blocks.push_back({ static_cast<std::byte*>(upstream->allocate(size, alignof(std::max_align_t))), size });
+}
+
+void framearena::releaseblocks()
+{
+	for (auto const& b : blocks)
+		upstream->deallocate(b.data, b.size, alignof(std::max_align_t));
+	blocks.clear();
+}
+
+poolresource::poolresource(uint blocksize, uint blocksperchunk, std::pmr::memory_resource* _upstream) : upstream(_upstream), chunkblocks(std::max<uint>(blocksperchunk, 1))
+{
+	// a free block has to hold the link to the next one
+	blockbytes = nextpowoftwomultiple(std::max<uint>(blocksize, sizeof(freeblock)), blockalignment);
+}
+
+poolresource::~poolresource()
+{
+	for (auto c : chunks)
+		upstream->deallocate(c, blockbytes * chunkblocks, blockalignment);
+}
+
+void* poolresource::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+	if (!fits(bytes, alignment))
+		return upstream->allocate(bytes, alignment);
+
+	if (!freelist)
+		addchunk();
+
+	auto const b = freelist;
+	freelist = b->next;
+	return b;
+}
+
+void poolresource::do_deallocate(void* p, std::size_t bytes, std::size_t alignment)
+{
+	if (!fits(bytes, alignment))
+	{
+		upstream->deallocate(p, bytes, alignment);
+		return;
+	}
+
+	auto const b = static_cast<freeblock*>(p);
+	b->next = freelist;
+	freelist = b;
+}
+
+void poolresource::addchunk()
+{
+	auto const chunk = static_cast<std::byte*>(upstream->allocate(blockbytes * chunkblocks, blockalignment));
+	chunks.push_back(chunk);
+
+	// link blocks so the first one of the chunk is handed out first
+	for (uint i(chunkblocks); i > 0; --i)
+	{
+		auto const b = reinterpret_cast<freeblock*>(chunk + (i - 1) * blockbytes);
+		b->next = freelist;
+		freelist = b;
+	}
+}
+
+}
@@ -0,0 +1,128 @@
+export module memory;
+
+import stdxcore;
+import std;
+
+export namespace stdx
+{
+
+// every call to the global operator new, counted by replacements of operator new and delete that the executable defines
+// unlike countingresource this sees plain std::vector and new allocations too
+class heapcounter
+{
+public:
+	static heapcounter& get();
+
+	void add(std::size_t bytes) { numallocations.fetch_add(1, std::memory_order_relaxed); numbytes.fetch_add(bytes, std::memory_order_relaxed); }
+
+	uint allocations() const { return numallocations.load(std::memory_order_relaxed); }
+	uint bytes() const { return numbytes.load(std::memory_order_relaxed); }
+	void resetcounts() { numallocations.store(0, std::memory_order_relaxed); numbytes.store(0, std::memory_order_relaxed); }
+
+private:
+	std::atomic<uint> numallocations = 0;
+	std::atomic<uint> numbytes = 0;
+};
+
+// forwards to upstream and counts what goes through it
+class countingresource : public std::pmr::memory_resource
+{
+public:
+	explicit countingresource(std::pmr::memory_resource* _upstream = std::pmr::new_delete_resource()) : upstream(_upstream) {}
+
+	// installed as the default pmr resource by the engine, so pmr allocations that fall through to the default resource show up per frame
+	// mostly upstream blocks of the frame arena, other heap traffic is only seen by heapcounter
+	static countingresource& get();
+
+	uint allocations() const { return numallocations.load(std::memory_order_relaxed); }
+	uint bytes() const { return numbytes.load(std::memory_order_relaxed); }
+	void resetcounts() { numallocations.store(0, std::memory_order_relaxed); numbytes.store(0, std::memory_order_relaxed); }
+
+private:
+	void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+	void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override { upstream->deallocate(p, bytes, alignment); }
+	bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override { return this == &other; }
+
+	std::pmr::memory_resource* upstream;
+	std::atomic<uint> numallocations = 0;
+	std::atomic<uint> numbytes = 0;
+};
+
+// monotonic arena for transient data, deallocation is a no-op and everything is released at once by reset()
+// not thread safe, meant for data produced and consumed within a frame on one thread
+class framearena : public std::pmr::memory_resource
+{
+public:
+	explicit framearena(uint initialsize = 1 << 20, std::pmr::memory_resource* _upstream = std::pmr::get_default_resource());
+	~framearena();
+
+	framearena(framearena const&) = delete;
+	framearena& operator=(framearena const&) = delete;
+
+	// reset by the engine at the start of every frame
+	static framearena& get();
+
+	// if the last frame spilled into more blocks they are merged into one, so steady state frames never touch upstream
+	void reset();
+
+	uint used() const { return usedbytes; }
+	uint capacity() const;
+
+private:
+	struct block
+	{
+		std::byte* data;
+		uint size;
+	};
+
+	void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+	void do_deallocate(void*, std::size_t, std::size_t) override {}
+	bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override { return this == &other; }
+
+	void addblock(uint size);
+	void releaseblocks();
+
+	std::pmr::memory_resource* upstream;
+	std::vector<block> blocks;
+	uint current = 0;
+	uint offset = 0;
+	uint usedbytes = 0;
+};
+
+// fixed size blocks carved from chunks, freed blocks are reused in lifo order
+// requests bigger than a block or with a stricter alignment go to upstream
+// not thread safe
+class poolresource : public std::pmr::memory_resource
+{
+public:
+	explicit poolresource(uint blocksize, uint blocksperchunk = 256, std::pmr::memory_resource* _upstream = std::pmr::get_default_resource());
+	~poolresource();
+
+	poolresource(poolresource const&) = delete;
+	poolresource& operator=(poolresource const&) = delete;
+
+	uint blocksize() const { return blockbytes; }
+
+private:
+	struct freeblock
+	{
+		freeblock* next;
+	};
+
+	static constexpr uint blockalignment = alignof(std::max_align_t);
+
+	void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+	void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override;
+	bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override { return this == &other; }
+
+	bool fits(std::size_t bytes, std::size_t alignment) const { return bytes <= blockbytes && alignment <= blockalignment; }
+	void addchunk();
+
+	std::pmr::memory_resource* upstream;
+	std::vector<std::byte*> chunks;
+	freeblock* freelist = nullptr;
+	uint blockbytes;
+	uint chunkblocks;
+};
+
+}
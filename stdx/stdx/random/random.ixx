@@ -0,0 +1,203 @@
+module;
+
+#include <immintrin.h>
+
+export module random;
+
+import stdxcore;
+import std;
+
+export namespace stdx
+{
+
+// seeds are expanded with splitmix64, so nearby seeds still give unrelated states
+constexpr uint64 splitmix64(uint64& state)
+{
+	uint64 z = (state += 0x9e3779b97f4a7c15ull);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+	return z ^ (z >> 31);
+}
+
+// xoshiro256** : 256 bits of state, period 2^256 - 1
+// satisfies std::uniform_random_bit_generator, but the std distributions are implementation defined
+// use the uniform helpers below when results have to be reproducible
+class xoshiro256
+{
+public:
+	using result_type = uint64;
+
+	static constexpr uint64 defaultseed = 0x5eed;
+
+	explicit constexpr xoshiro256(uint64 seed = defaultseed)
+	{
+		for (auto& v : s)
+			v = splitmix64(seed);
+	}
+
+	static constexpr result_type min() { return 0; }
+	static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+	constexpr result_type operator()()
+	{
+		uint64 const r = std::rotl(s[1] * 5, 7) * 9;
+		uint64 const t = s[1] << 17;
+
+		s[2] ^= s[0];
+		s[3] ^= s[1];
+		s[1] ^= s[2];
+		s[0] ^= s[3];
+		s[2] ^= t;
+		s[3] = std::rotl(s[3], 45);
+
+		return r;
+	}
+
+	// advances the state by 2^128 calls, so jumps hand out 2^128 non overlapping streams
+	constexpr void jump()
+	{
+		constexpr uint64 jumppoly[] = { 0x180ec6d33cfd0abaull, 0xd5a61266f0c9392cull, 0xa9582618e03fc9aaull, 0x39abdc4529b1661cull };
+
+		std::array<uint64, 4> r{};
+		for (auto const poly : jumppoly)
+		{
+			for (uint b(0); b < 64; ++b)
+			{
+				if (poly & (1ull << b))
+				{
+					for (uint i(0); i < 4; ++i)
+						r[i] ^= s[i];
+				}
+				operator()();
+			}
+		}
+
+		s = r;
+	}
+
+	// returns a generator for the current stream and moves this one to the next stream
+	// e.g. one split per job gives every thread its own deterministic sequence
+	constexpr xoshiro256 split()
+	{
+		xoshiro256 r = *this;
+		jump();
+		return r;
+	}
+
+	// uniform float in [0, 1), top 24 bits so every value is exactly representable
+	constexpr float uniformf() { return static_cast<float>(operator()() >> 40) * 0x1.0p-24f; }
+	constexpr float uniformf(float lo, float hi) { return lo + (hi - lo) * uniformf(); }
+
+	// uniform integer in [0, n), multiply and shift with rejection to remove the bias (lemire)
+	constexpr uint32 uniform(uint32 n)
+	{
+		uint64 m = (operator()() >> 32) * n;
+		if (static_cast<uint32>(m) < n)
+		{
+			uint32 const threshold = (0u - n) % n;
+			while (static_cast<uint32>(m) < threshold)
+				m = (operator()() >> 32) * n;
+		}
+
+		return static_cast<uint32>(m >> 32);
+	}
+
+	constexpr uint32 uniform(uint32 lo, uint32 hi) { return lo + uniform(hi - lo + 1); }
+
+private:
+	friend class xoshiro256x4;
+
+	std::array<uint64, 4> s;
+};
+
+// four xoshiro256+ streams advanced together, for filling large buffers with uniform floats
+// xoshiro256+ needs no multiply, which avx2 lacks for 64 bit lanes
+// the avx2 and scalar paths produce the same sequence
+class xoshiro256x4
+{
+public:
+	// lanes are consecutive jumps of the seeding generator, so they never overlap
+	explicit constexpr xoshiro256x4(xoshiro256 seeder = xoshiro256{})
+	{
+		for (uint l(0); l < 4; ++l)
+		{
+			auto const lane = seeder.split();
+			for (uint i(0); i < 4; ++i)
+				s[i][l] = lane.s[i];
+		}
+	}
+
+	// uniform floats in [0, 1), 8 per step from bits 9-31 and 41-63 of each lane
+	// the lowest bits of xoshiro256+ are weak, so they are dropped
+	void fill(std::span<float> r)
+	{
+		uint const numsteps = r.size() / 8;
+		for (uint i(0); i < numsteps; ++i)
+			step(r.data() + i * 8);
+
+		if (uint const rem = r.size() % 8; rem != 0)
+		{
+			alignas(32) float tail[8];
+			step(tail);
+			std::copy_n(tail, rem, r.data() + numsteps * 8);
+		}
+	}
+
+	void fill(std::span<float> r, float lo, float hi)
+	{
+		fill(r);
+		for (auto& v : r)
+			v = lo + (hi - lo) * v;
+	}
+
+private:
+	void step(float* r)
+	{
+#if defined(__AVX2__)
+		auto const s0 = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(s[0].data()));
+		auto const s1 = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(s[1].data()));
+		auto s2 = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(s[2].data()));
+		auto s3 = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(s[3].data()));
+
+		auto const bits = _mm256_add_epi64(s0, s3);
+		auto const t = _mm256_slli_epi64(s1, 17);
+
+		s2 = _mm256_xor_si256(s2, s0);
+		s3 = _mm256_xor_si256(s3, s1);
+		auto const n1 = _mm256_xor_si256(s1, s2);
+		auto const n0 = _mm256_xor_si256(s0, s3);
+		s2 = _mm256_xor_si256(s2, t);
+		s3 = _mm256_or_si256(_mm256_slli_epi64(s3, 45), _mm256_srli_epi64(s3, 19));
+
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(s[0].data()), n0);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(s[1].data()), n1);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(s[2].data()), s2);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(s[3].data()), s3);
+
+		// 23 bits into the mantissa of a float in [1, 2)
+		auto const mantissa = _mm256_or_si256(_mm256_srli_epi32(bits, 9), _mm256_set1_epi32(0x3f800000));
+		_mm256_storeu_ps(r, _mm256_sub_ps(_mm256_castsi256_ps(mantissa), _mm256_set1_ps(1.f)));
+#else
+		for (uint l(0); l < 4; ++l)
+		{
+			uint64 const bits = s[0][l] + s[3][l];
+			uint64 const t = s[1][l] << 17;
+
+			s[2][l] ^= s[0][l];
+			s[3][l] ^= s[1][l];
+			s[1][l] ^= s[2][l];
+			s[0][l] ^= s[3][l];
+			s[2][l] ^= t;
+			s[3][l] = std::rotl(s[3][l], 45);
+
+			r[l * 2] = std::bit_cast<float>(static_cast<uint32>(bits) >> 9 | 0x3f800000u) - 1.f;
+			r[l * 2 + 1] = std::bit_cast<float>(static_cast<uint32>(bits >> 32) >> 9 | 0x3f800000u) - 1.f;
+		}
+#endif
+	}
+
+	// s[i][lane], so each state word of the four lanes is one avx2 register
+	std::array<std::array<uint64, 4>, 4> s;
+};
+
+}
@@ -1,3 +1,13 @@
+module;
+
+#include <immintrin.h>
+
+// avx2 doesn't imply bmi2 for gcc and clang, they define __BMI2__ when it's enabled
+// msvc accepts bmi2 intrinsics under any /arch and every cpu with avx2 it targets has bmi2
+#if defined(__BMI2__) || (defined(_MSC_VER) && !defined(__clang__) && defined(__AVX2__))
+#define STDX_BMI2 1
+#endif
+
 export module stdx;
 
 import stdxcore;
@@ -25,32 +35,42 @@ constexpr std::array<uint, n> getdigits(uint d)
 template<uint n>
 struct triindex
 {
+	// number of indices in a triangle of degree n
+	static constexpr uint count = (n + 1) * (n + 2) / 2;
+
+	constexpr triindex() = default;
 	constexpr triindex(uint _i, uint _j, uint _k) : i(_i), j(_j), k(_k) {}
 	constexpr uint to1d() const { return to1d(this->j, this->k); }
 	static constexpr uint to1d(uint j, uint k) { return (n - j) * (n - j + 1) / 2 + k; }         // n - j gives us row index
 
-	static triindex to3d(uint idx1d)
-	{
-		// determine which row the point belongs to
-		// this was derived empirically
-		float const temp = (std::sqrt((static_cast<float>(idx1d) + 1.f) * 8.f + 1.f) - 1.f) / 2.0f - tolerance<>;
+	static constexpr triindex to3d(uint idx1d);
+
+	// all indices of the triangle in 1d order, for (auto const& idx : triindex<n>::all()) walks the triangular domain
+	static constexpr std::array<triindex, count> const& all();
 
-		// convert to 0 based index
-		uint const row = static_cast<uint>(ceil(temp)) - 1u;
+	uint i = 0, j = 0, k = 0;
+};
 
-		// this will give the index of starting vertex of the row
-		// number of vertices till row n(0-based) is n(n+1)/2
-		uint const rowstartvertex = (row) * (row + 1) / 2;
+// 1d -> 3d lookup, built at compile time since the degree is known
+template<uint n>
+inline constexpr std::array<triindex<n>, triindex<n>::count> triindices = []()
+{
+	std::array<triindex<n>, triindex<n>::count> r;
+	uint idx = 0;
 
-		uint const j = n - row;
-		uint const k = idx1d - rowstartvertex;
-		uint const i = n - j - k;
+	// row r starts at r(r+1)/2 and holds r + 1 indices
+	for (uint row(0); row <= n; ++row)
+		for (uint k(0); k <= row; ++k)
+			r[idx++] = triindex<n>(row - k, n - row, k);
 
-		return triindex(i, j, k);
-	}
+	return r;
+}();
 
-	uint i, j, k;
-};
+template<uint n>
+constexpr triindex<n> triindex<n>::to3d(uint idx1d) { return triindices<n>[idx1d]; }
+
+template<uint n>
+constexpr std::array<triindex<n>, triindex<n>::count> const& triindex<n>::all() { return triindices<n>; }
 
 // n is dimension of the grid(0 based)
 template<uint n>
@@ -62,7 +82,7 @@ struct grididx : public vec<n + 1, uint>
 	explicit constexpr grididx(uint idx) : stdx::vec<n + 1, uint>(getdigits<n + 1>(idx)) {}
 	template<uint_c ... args>
 	requires (sizeof...(args) == (n + 1))
-	constexpr grididx(args... _coords) : grididx{ static_cast<uint>(_coords)... } {}
+	constexpr grididx(args... _coords) : stdx::vec<n + 1, uint>{ static_cast<uint>(_coords)... } {}
 
 	// d is degree(0 based)
 	static constexpr uint to1d(uint d, grididx const& idx)
@@ -90,8 +110,155 @@ struct grididx : public vec<n + 1, uint>
 		res[d] = 1;
 		return res;
 	}
+
+	// all indices of a grid of degree d in to1d order
+	static constexpr auto range(uint d);
 };
 
+// steps through a grid with idx[0] changing fastest, advancing only adds and carries
+template<uint n>
+struct griditer
+{
+	constexpr grididx<n> const& operator*() const { return idx; }
+	constexpr bool operator!=(griditer const& rhs) const { return linear != rhs.linear; }
+	constexpr griditer& operator++()
+	{
+		++linear;
+		for (uint i(0); i <= n; ++i)
+		{
+			if (++idx[i] < extents[i]) break;
+			if (i < n) idx[i] = 0;
+		}
+
+		return *this;
+	}
+
+	// position in to1d order
+	constexpr uint position() const { return linear; }
+
+	grididx<n> idx;
+	grididx<n> extents;
+	uint linear;
+};
+
+template<uint n>
+struct gridrange
+{
+	constexpr gridrange(grididx<n> const& _extents) : extents(_extents) {}
+
+	constexpr griditer<n> begin() const { return { grididx<n>{}, extents, 0 }; }
+	constexpr griditer<n> end() const { return { grididx<n>{}, extents, size() }; }
+	constexpr uint size() const
+	{
+		uint r = 1;
+		for (auto e : extents) r *= e;
+		return r;
+	}
+
+	grididx<n> extents;
+};
+
+template<uint n>
+requires (n >= 0)
+constexpr auto grididx<n>::range(uint d) { return gridrange<n>(grididx<n>(vec<n + 1, uint>::filled(d + 1))); }
+
+// z-order index for 2d and 3d grids, cells that are close in the grid stay close in the order
+// uses bmi2 pdep/pext when available
+template<uint n>
+requires (n == 1 || n == 2)
+struct mortonidx
+{
+	using code_t = std::uint64_t;
+
+	// bits per coordinate, 32 in 2d and 21 in 3d
+	static constexpr uint coordbits = 64 / (n + 1);
+
+	static constexpr code_t axismask(uint axis)
+	{
+		code_t m = 0;
+		for (uint b(0); b < coordbits; ++b) m |= code_t(1) << (b * (n + 1) + axis);
+		return m;
+	}
+
+	static constexpr code_t encode(grididx<n> const& idx)
+	{
+		code_t r = 0;
+		for (uint a(0); a <= n; ++a)
+		{
+#if defined(STDX_BMI2)
+			if (!std::is_constant_evaluated())
+			{
+				r |= _pdep_u64(idx[a], axismask(a));
+				continue;
+			}
+#endif
+			for (uint b(0); b < coordbits; ++b)
+				r |= ((code_t(idx[a]) >> b) & 1) << (b * (n + 1) + a);
+		}
+
+		return r;
+	}
+
+	static constexpr grididx<n> decode(code_t code)
+	{
+		grididx<n> r;
+		for (uint a(0); a <= n; ++a)
+		{
+#if defined(STDX_BMI2)
+			if (!std::is_constant_evaluated())
+			{
+				r[a] = static_cast<uint>(_pext_u64(code, axismask(a)));
+				continue;
+			}
+#endif
+			r[a] = 0;
+			for (uint b(0); b < coordbits; ++b)
+				r[a] |= static_cast<uint>((code >> (b * (n + 1) + a)) & 1) << b;
+		}
+
+		return r;
+	}
+
+	constexpr mortonidx() = default;
+	constexpr mortonidx(grididx<n> const& idx) : code(encode(idx)) {}
+	constexpr operator grididx<n>() const { return decode(code); }
+
+	code_t code = 0;
+};
+
+// visits the cells of the octant with low corner base and the given power of two size in z-order
+// the children of an octant are its next code digit in increasing order, children that start past d hold no cells and are skipped whole
+template<uint n, typename f_t>
+constexpr void mortonoctant(uint d, uint size, grididx<n> const& base, f_t& f)
+{
+	uint const half = size / 2;
+	for (uint c(0); c < (1u << (n + 1)); ++c)
+	{
+		grididx<n> child = base;
+		bool inside = true;
+		for (uint a(0); a <= n; ++a)
+		{
+			child[a] += ((c >> a) & 1) * half;
+			inside = inside && child[a] <= d;
+		}
+
+		if (!inside) continue;
+		if (half == 1) f(std::as_const(child));
+		else mortonoctant<n>(d, half, child, f);
+	}
+}
+
+// visits a grid of degree d in z-order, stepping coordinates octant by octant instead of decoding codes
+// z-order only pays off for data laid out by morton code, sweeping a linearly stored grid this way is slower than grididx::range
+template<uint n, typename f_t>
+requires std::invocable<f_t&, grididx<n> const&>
+constexpr void mortonsweep(uint d, f_t&& f)
+{
+	uint const side = std::bit_ceil(d + 1);
+	if (side == 1) f(grididx<n>{});
+	else mortonoctant<n>(d, side, grididx<n>{}, f);
+}
+
 template<typename b, typename e>
 struct ext
 {
@@ -118,19 +285,29 @@ struct ext
 template<typename t, indexablecontainer_c... args_t>
 struct join;
 
+// walks one container at a time, so increment and dereference don't depend on the number of containers
 template<typename t, indexablecontainer_c... args_t>
 struct joiniter
 {
-	using idx_t = uint;
 	using join_t = join<t, args_t...>;
 
-	joiniter(join_t* _join, uint _idx) : join(_join), idx(_idx) {}
-	t* operator*() { return join->get(idx); }
-	bool operator!=(joiniter const& rhs) const { return idx != rhs.idx || join != rhs.join; }
-	joiniter& operator++() { idx++; return *this; }
+	joiniter(join_t* _join, uint _container, uint _idx) : join(_join), container(_container), idx(_idx) {}
+	t* operator*() const { return join_t::getters[container](join->data, idx); }
+	bool operator!=(joiniter const& rhs) const { return idx != rhs.idx || container != rhs.container || join != rhs.join; }
+	joiniter& operator++()
+	{
+		if (++idx == join->sizes[container])
+		{
+			idx = 0;
+			container = join->nextnonempty(container + 1);
+		}
+
+		return *this;
+	}
 
-	idx_t idx;
 	join_t* join;
+	uint container;
+	uint idx;
 };
 
 template<typename t, indexablecontainer_c... args_t>
@@ -138,69 +315,89 @@ struct join
 {
 private:
 	using iter_t = joiniter<t, args_t...>;
-	friend struct iter_t;
+	using data_t = std::tuple<args_t&...>;
+	using getter_t = t* (*)(data_t&, uint);
+	friend iter_t;
 	static constexpr uint mysize = sizeof...(args_t);
 
+	template<uint n>
+	static t* getat(data_t& data, uint idx) { return static_cast<t*>(&(std::get<n>(data)[idx])); }
+
+	// dereference is a lookup in this table rather than a walk over the containers
+	static constexpr std::array<getter_t, mysize> getters = []<uint... n>(std::integer_sequence<uint, n...>) { return std::array<getter_t, mysize>{ &getat<n>... }; }(std::make_integer_sequence<uint, mysize>{});
+
 public:
 	join(args_t&... _args) : data(_args...) {}
+
+	// sizes are cached here, containers shouldn't change size while iterating
 	iter_t begin()
 	{
-		if (calcsizes() == 0) return end();
-		return iter_t(this, 0);
+		calcsizes();
+		return iter_t(this, nextnonempty(0), 0);
 	}
-	iter_t end() { return iter_t(this, calcsizes()); }
+
+	iter_t end() { return iter_t(this, mysize, 0); }
+
+	uint size() { return calcsizes(); }
+
+	// spans need contiguous storage, iteration only needs indexing
+	static constexpr bool contiguous = (std::ranges::contiguous_range<args_t> && ...);
+
+	// calls f with a span of each container in turn, the elements keep their concrete type
+	template<typename f_t>
+	requires contiguous
+	void visit(f_t&& f) { visit(0, calcsizes(), f); }
+
+	// visits the part of [b, e) that falls in each container, spans use sizes cached by the last begin/size/visit
+	template<typename f_t>
+	requires contiguous
+	void visit(uint b, uint e, f_t&& f) { visitimpl<0>(b, e, 0, f); }
+
+	template<typename f_t>
+	requires contiguous && std::invocable<f_t&, t&>
+	void for_each(f_t&& f) { visit([&](auto elems) { for (auto& e : elems) f(static_cast<t&>(e)); }); }
 
 private:
 	uint calcsizes()
 	{
 		uint totalsize = 0;
-		for (uint i = 0; i < mysize; ++i) { sizes[i] = getsize(i); totalsize += sizes[i]; }
+		calcsizesimpl(totalsize);
 		return totalsize;
 	}
 
-	std::pair<uint, uint> container(uint idx) const
+	template<uint n = 0>
+	void calcsizesimpl(uint& totalsize)
 	{
-		static constexpr auto invalidcont = std::make_pair(invalid<uint>, invalid<uint>);
-		uint sum = 0;
-		std::pair<uint, uint> ret = invalidcont;
-		for (uint i = 0; i < sizes.size(); ++i)
+		if constexpr (n < mysize)
 		{
-			sum += sizes[i];
-			if (idx < sum) return { idx - sum + sizes[i], i };
+			sizes[n] = std::get<n>(data).size();
+			totalsize += sizes[n];
+			calcsizesimpl<n + 1>(totalsize);
 		}
-		return ret;
 	}
 
-	t* get(uint idx)
+	uint nextnonempty(uint container) const
 	{
-		stdx::cassert([&]() { return idx < calcsizes(); });
-
-		auto const& [idxrel, idxc] = container(idx);
-		return getimpl(idxrel, idxc);
+		while (container < mysize && sizes[container] == 0) ++container;
+		return container;
 	}
 
-	template<uint n = 0>
-	t* getimpl(uint idx, uint idxc)
+	template<uint n, typename f_t>
+	void visitimpl(uint b, uint e, uint offset, f_t& f)
 	{
-		stdx::cassert(idxc < mysize);
-		if (n == idxc)
-			return static_cast<t*>(&(std::get<n>(data)[idx]));
-		if constexpr (n + 1 < mysize) return getimpl<n + 1>(idx, idxc);
-		return nullptr;
-	}
-
-	template<uint n = 0>
-	uint getsize(uint idxc) const
-	{
-		stdx::cassert(idxc < mysize);
+		if constexpr (n < mysize)
+		{
+			uint const s = std::max(b, offset), l = std::min(e, offset + sizes[n]);
+			if (s < l)
+				f(std::span(std::get<n>(data)).subspan(s - offset, l - s));
 
-		if (n == idxc) return std::get<n>(data).size();
-		if constexpr (n + 1 < mysize) return getsize<n + 1>(idxc);
-		return 0;
+			if (e > offset + sizes[n])
+				visitimpl<n + 1>(b, e, offset + sizes[n], f);
+		}
 	}
 
-	std::array<uint, mysize> sizes;
-	std::tuple<args_t&...> data;
+	std::array<uint, mysize> sizes{};
+	data_t data;
 };
 
 template<typename t, typename... args_t>
@@ -1,4 +1,5 @@
 export module vec;
+export import :simd;
 
 import stdxcore;
 import std;
@@ -9,22 +10,24 @@ export namespace stdx
 template<uint d, stdx::arithmeticpure_c t = float>
 struct vec : public std::array<t, d>
 {
+	using kernels = stdx::simd::veckernels<d, t>;
+
 	static constexpr uint nd = d;
-	constexpr vec operator-() const { return stdx::unaryop(*this, stdx::uminus()); }
-	constexpr vec operator+(vec r) const { return stdx::binaryop(*this, r, std::plus<>()); }
-	constexpr vec operator-(vec r) const { return stdx::binaryop(*this, r, std::minus<>()); }
-	constexpr vec operator*(vec r) const { return stdx::binaryop(*this, r, std::multiplies<>()); }
-	constexpr vec operator/(vec r) const { return stdx::binaryop(*this, r, std::divides<>()); }
-	constexpr vec operator+(t r) const { return stdx::unaryop(*this, std::bind(std::plus<>(), std::placeholders::_1, r)); }
-	constexpr vec operator-(t r) const { return stdx::unaryop(*this, std::bind(std::minus<>(), std::placeholders::_1, r)); }
-	constexpr vec operator*(t r) const { return stdx::unaryop(*this, std::bind(std::multiplies<>(), std::placeholders::_1, r)); }
-	constexpr vec operator/(t r) const { return stdx::unaryop(*this, std::bind(std::divides<>(), std::placeholders::_1, r)); }
+	constexpr vec operator-() const { return { kernels::neg(*this) }; }
+	constexpr vec operator+(vec const& r) const { return { kernels::add(*this, r) }; }
+	constexpr vec operator-(vec const& r) const { return { kernels::sub(*this, r) }; }
+	constexpr vec operator*(vec const& r) const { return { kernels::mul(*this, r) }; }
+	constexpr vec operator/(vec const& r) const { return { kernels::div(*this, r) }; }
+	constexpr vec operator+(t r) const { return { kernels::add(*this, r) }; }
+	constexpr vec operator-(t r) const { return { kernels::sub(*this, r) }; }
+	constexpr vec operator*(t r) const { return { kernels::mul(*this, r) }; }
+	constexpr vec operator/(t r) const { return { kernels::div(*this, r) }; }
 	constexpr bool operator==(vec r) const { return stdx::equals(*this, r, t(0)); }
 	constexpr bool operator==(t r) const { return stdx::equals(*this, r, t(0)); }
 
 	constexpr operator t() const requires (d == 1) { return (*this)[0]; }
 
-	constexpr t dot(vec const& r) const { return stdx::dot(*this, r); }
+	constexpr t dot(vec const& r) const { return kernels::dot(*this, r); }
 	constexpr vec normalized() const;
 	constexpr vec cross(vec const& r) const requires (d == 3);
 	constexpr t distancesqr(vec const& r) const;
@@ -43,26 +46,62 @@ struct vec : public std::array<t, d>
 	constexpr std::string str() const;
 };
 
-// todo : could merge vec and matrix(use recursive template array)
+// row major, vectors are rows and transform as v * m(same convention as simplemath)
+// 4x4 float uses the sse kernels, other sizes are built on vec row ops
 template<uint r, uint c, stdx::arithmeticpure_c t = float>
 struct matrix : public std::array<vec<c, t>, r>
 {
+	using row_t = vec<c, t>;
+
+	static constexpr uint nr = r;
+	static constexpr uint nc = c;
+	static constexpr bool simd = (r == 4 && c == 4 && std::is_same_v<t, float>);
+
+	constexpr matrix operator+(matrix const& m) const { matrix res; for (uint i(0); i < r; ++i) res[i] = (*this)[i] + m[i]; return res; }
+	constexpr matrix operator-(matrix const& m) const { matrix res; for (uint i(0); i < r; ++i) res[i] = (*this)[i] - m[i]; return res; }
+	constexpr matrix operator*(t s) const { matrix res; for (uint i(0); i < r; ++i) res[i] = (*this)[i] * s; return res; }
+
+	template<uint k>
+	constexpr matrix<r, k, t> operator*(matrix<c, k, t> const& m) const;
+
+	constexpr matrix<c, r, t> transpose() const;
+	constexpr vec<c, t> transform(vec<r, t> const& v) const;
+	constexpr vec<3, t> transformpoint(vec<3, t> const& p) const requires (r == 4 && c == 4);
+	constexpr vec<3, t> transformnormal(vec<3, t> const& n) const requires (r == c && r >= 3);
+
+	constexpr t determinant() const requires (r == c);
+	constexpr matrix inverse() const requires (r == c);
+
+	// fast paths for transforms with (0, 0, 0, 1) as the last column
+	// affine allows any invertible upper 3x3, rigid requires it to be a rotation
+	constexpr matrix inverseaffine() const requires (r == 4 && c == 4);
+	constexpr matrix inverserigid() const requires (r == 4 && c == 4);
+
+	static constexpr matrix identity() requires (r == c) { matrix res{}; for (uint i(0); i < r; ++i) res[i] = row_t::unit(i); return res; }
+	static constexpr matrix translation(vec<3, t> const& v) requires (r == 4 && c == 4) { matrix res = identity(); res[3] = { v[0], v[1], v[2], t(1) }; return res; }
+	static constexpr matrix scale(vec<3, t> const& s) requires (r == c && r >= 3) { matrix res = identity(); for (uint i(0); i < 3; ++i) res[i][i] = s[i]; return res; }
 };
 
 template<stdx::arithmeticpure_c t, uint d>
-vec<d, t> operator*(t l, vec<d, t> r) { return { stdx::unaryop(r, std::bind(std::multiplies<>(), std::placeholders::_1, l)) }; }
+constexpr vec<d, t> operator*(t l, vec<d, t> const& r) { return r * l; }
+
+template<stdx::arithmeticpure_c t, uint r, uint c>
+constexpr vec<c, t> operator*(vec<r, t> const& v, matrix<r, c, t> const& m) { return m.transform(v); }
+
+template<stdx::arithmeticpure_c t, uint r, uint c>
+constexpr matrix<r, c, t> operator*(t s, matrix<r, c, t> const& m) { return m * s; }
 
 template<stdx::arithmeticpure_c t, uint d>
-vec<d, t> operator+=(vec<d, t>& l, vec<d, t> r) { l = stdx::binaryop(l, r, std::plus<>()); return l; }
+constexpr vec<d, t>& operator+=(vec<d, t>& l, vec<d, t> const& r) { l = l + r; return l; }
 
 template<stdx::arithmeticpure_c t, uint d>
-vec<d, t> operator-=(vec<d, t>& l, vec<d, t> r) { l = stdx::binaryop(l, r, std::minus<>()); return l; }
+constexpr vec<d, t>& operator-=(vec<d, t>& l, vec<d, t> const& r) { l = l - r; return l; }
 
 template<stdx::arithmeticpure_c t, uint d>
-vec<d, t> operator*=(vec<d, t>& l, t r) { l = stdx::unaryop(l, std::bind(std::multiplies<>(), std::placeholders::_1, r)); return l; }
+constexpr vec<d, t>& operator*=(vec<d, t>& l, t r) { l = l * r; return l; }
 
 template<stdx::arithmeticpure_c t, uint d>
-vec<d, t> operator/=(vec<d, t> l, t r) { l = stdx::unaryop(l, std::bind(std::multiplies<>(), std::placeholders::_1, t(1) / r)); return l; }
+constexpr vec<d, t>& operator/=(vec<d, t>& l, t r) { l = l / r; return l; }
 
 template<uint d>
 using veci = vec<d, int>;
@@ -132,10 +171,346 @@ constexpr std::string vec<d, t>::str() const
 template<uint d, stdx::arithmeticpure_c t>
 constexpr vec<d, t> vec<d, t>::normalized() const
 {
-	vec r = *this;
-	return r / static_cast<t>(std::sqrt(r.dot(r)) + 1.17e-38f);
+	return *this * (t(1) / static_cast<t>(std::sqrt(dot(*this)) + 1.17e-38f));
+}
+
+template<uint r, uint c, stdx::arithmeticpure_c t>
+template<uint k>
+constexpr matrix<r, k, t> matrix<r, c, t>::operator*(matrix<c, k, t> const& m) const
+{
+	matrix<r, k, t> res;
+	if constexpr (simd && k == 4)
+	{
+		if (!std::is_constant_evaluated())
+		{
+			simd::mat4kernels::mul(this->front().data(), m.front().data(), res.front().data());
+			return res;
+		}
+	}
+
+	for (uint i(0); i < r; ++i)
+		res[i] = m.transform((*this)[i]);
+
+	return res;
+}
+
+template<uint r, uint c, stdx::arithmeticpure_c t>
+constexpr matrix<c, r, t> matrix<r, c, t>::transpose() const
+{
+	matrix<c, r, t> res;
+	if constexpr (simd)
+	{
+		if (!std::is_constant_evaluated())
+		{
+			simd::mat4kernels::transpose(this->front().data(), res.front().data());
+			return res;
+		}
+	}
+
+	for (uint i(0); i < r; ++i)
+		for (uint j(0); j < c; ++j)
+			res[j][i] = (*this)[i][j];
+
+	return res;
+}
+
+template<uint r, uint c, stdx::arithmeticpure_c t>
+constexpr vec<c, t> matrix<r, c, t>::transform(vec<r, t> const& v) const
+{
+	vec<c, t> res;
+	if constexpr (simd)
+	{
+		if (!std::is_constant_evaluated())
+		{
+			simd::mat4kernels::transform(v.data(), this->front().data(), res.data());
+			return res;
+		}
+	}
+
+	// linear combination of the rows
+	res = (*this)[0] * v[0];
+	for (uint i(1); i < r; ++i)
+		res += (*this)[i] * v[i];
+
+	return res;
+}
+
+template<uint r, uint c, stdx::arithmeticpure_c t>
+constexpr vec<3, t> matrix<r, c, t>::transformpoint(vec<3, t> const& p) const requires (r == 4 && c == 4)
+{
+	auto const res = transform({ p[0], p[1], p[2], t(1) });
+	return { res[0], res[1], res[2] };
+}
+
+template<uint r, uint c, stdx::arithmeticpure_c t>
+constexpr vec<3, t> matrix<r, c, t>::transformnormal(vec<3, t> const& n) const requires (r == c && r >= 3)
+{
+	vec<3, t> res = { (*this)[0][0], (*this)[0][1], (*this)[0][2] };
+	res = res * n[0];
+	for (uint i(1); i < 3; ++i)
+		res += vec<3, t>{ (*this)[i][0], (*this)[i][1], (*this)[i][2] } * n[i];
+
+	return res;
+}
+
+template<uint r, uint c, stdx::arithmeticpure_c t>
+constexpr t matrix<r, c, t>::determinant() const requires (r == c)
+{
+	auto const& m = *this;
+	if constexpr (r == 1) return m[0][0];
+	else if constexpr (r == 2) return m[0][0] * m[1][1] - m[0][1] * m[1][0];
+	else if constexpr (r == 3) return m[0].dot(m[1].cross(m[2]));
+	else
+	{
+		if constexpr (simd)
+		{
+			if (!std::is_constant_evaluated())
+			{
+				matrix inv;
+				return simd::mat4kernels::inverse(m.front().data(), inv.front().data());
+			}
+		}
+
+		// gaussian elimination with partial pivoting
+		matrix a = m;
+		t det = t(1);
+		for (uint col(0); col < r; ++col)
+		{
+			uint pivot = col;
+			for (uint i(col + 1); i < r; ++i)
+				if ((a[i][col] < 0 ? -a[i][col] : a[i][col]) > (a[pivot][col] < 0 ? -a[pivot][col] : a[pivot][col])) pivot = i;
+
+			if (a[pivot][col] == t(0)) return t(0);
+			if (pivot != col) { std::swap(a[pivot], a[col]); det = -det; }
+
+			det *= a[col][col];
+			for (uint i(col + 1); i < r; ++i)
+				a[i] -= a[col] * (a[i][col] / a[col][col]);
+		}
+
+		return det;
+	}
 }
 
+template<uint r, uint c, stdx::arithmeticpure_c t>
+constexpr matrix<r, c, t> matrix<r, c, t>::inverse() const requires (r == c)
+{
+	auto const& m = *this;
+	if constexpr (r == 3)
+	{
+		// columns of the inverse are the cross products of the rows
+		vec<3, t> const r0 = m[0], r1 = m[1], r2 = m[2];
+		vec<3, t> const c0 = r1.cross(r2), c1 = r2.cross(r0), c2 = r0.cross(r1);
+		t const rdet = t(1) / r0.dot(c0);
+		return matrix{ c0 * rdet, c1 * rdet, c2 * rdet }.transpose();
+	}
+	else
+	{
+		matrix res;
+		if constexpr (simd)
+		{
+			if (!std::is_constant_evaluated())
+			{
+				simd::mat4kernels::inverse(m.front().data(), res.front().data());
+				return res;
+			}
+		}
+
+		// gauss-jordan with partial pivoting
+		matrix a = m;
+		res = identity();
+		for (uint col(0); col < r; ++col)
+		{
+			uint pivot = col;
+			for (uint i(col + 1); i < r; ++i)
+				if ((a[i][col] < 0 ? -a[i][col] : a[i][col]) > (a[pivot][col] < 0 ? -a[pivot][col] : a[pivot][col])) pivot = i;
+
+			std::swap(a[pivot], a[col]);
+			std::swap(res[pivot], res[col]);
+
+			t const rpivot = t(1) / a[col][col];
+			a[col] *= rpivot;
+			res[col] *= rpivot;
+			for (uint i(0); i < r; ++i)
+			{
+				if (i == col) continue;
+				t const f = a[i][col];
+				a[i] -= a[col] * f;
+				res[i] -= res[col] * f;
+			}
+		}
+
+		return res;
+	}
+}
+
+template<uint r, uint c, stdx::arithmeticpure_c t>
+constexpr matrix<r, c, t> matrix<r, c, t>::inverseaffine() const requires (r == 4 && c == 4)
+{
+	auto const& m = *this;
+	matrix<3, 3, t> const inv = matrix<3, 3, t>{ vec<3, t>{ m[0][0], m[0][1], m[0][2] }, vec<3, t>{ m[1][0], m[1][1], m[1][2] }, vec<3, t>{ m[2][0], m[2][1], m[2][2] } }.inverse();
+	vec<3, t> const tr = -inv.transform({ m[3][0], m[3][1], m[3][2] });
+	return { row_t{ inv[0][0], inv[0][1], inv[0][2], t(0) }, row_t{ inv[1][0], inv[1][1], inv[1][2], t(0) }, row_t{ inv[2][0], inv[2][1], inv[2][2], t(0) }, row_t{ tr[0], tr[1], tr[2], t(1) } };
+}
+
+template<uint r, uint c, stdx::arithmeticpure_c t>
+constexpr matrix<r, c, t> matrix<r, c, t>::inverserigid() const requires (r == 4 && c == 4)
+{
+	// inverse of a rotation is its transpose
+	auto const& m = *this;
+	vec<3, t> const tr = -matrix<3, 3, t>{ vec<3, t>{ m[0][0], m[1][0], m[2][0] }, vec<3, t>{ m[0][1], m[1][1], m[2][1] }, vec<3, t>{ m[0][2], m[1][2], m[2][2] } }.transform({ m[3][0], m[3][1], m[3][2] });
+	return { row_t{ m[0][0], m[1][0], m[2][0], t(0) }, row_t{ m[0][1], m[1][1], m[2][1], t(0) }, row_t{ m[0][2], m[1][2], m[2][2], t(0) }, row_t{ tr[0], tr[1], tr[2], t(1) } };
+}
+
+// lazy vec expressions, opt in by wrapping operands with stdx::lazy()
+// a compound expression is evaluated component wise in one pass when it is converted to a vec, so sub expressions don't create temporaries
+// operands are held by reference, so an expression shouldn't outlive the full expression that created it
+template<typename t>
+concept vecexpr_c = requires { typename std::decay_t<t>::vecexpr_tag; };
+
+template<typename e_t>
+struct vecexprbase
+{
+	constexpr auto eval() const;
+	constexpr auto normalized() const;
+	constexpr auto length() const { auto const r = eval(); return std::sqrt(r.dot(r)); }
+	constexpr auto dot(auto const& r) const;
+
+	template<uint d, typename t>
+	constexpr operator vec<d, t>() const requires (d == e_t::nd && std::same_as<t, typename e_t::value_type>) { return eval(); }
+
+private:
+	constexpr e_t const& self() const { return static_cast<e_t const&>(*this); }
+};
+
+template<uint d, stdx::arithmeticpure_c t>
+struct vecref : public vecexprbase<vecref<d, t>>
+{
+	using vecexpr_tag = void;
+	using value_type = t;
+	static constexpr uint nd = d;
+
+	constexpr vecref(vec<d, t> const& _v) : v(_v) {}
+	constexpr t operator[](uint i) const { return v[i]; }
+
+	vec<d, t> const& v;
+};
+
+// scalar operand, broadcast to every component
+template<stdx::arithmeticpure_c t>
+struct vecscalar
+{
+	using vecexpr_tag = void;
+	using value_type = t;
+	static constexpr uint nd = 0;
+
+	constexpr t operator[](uint) const { return s; }
+
+	t s;
+};
+
+template<typename l_t, typename r_t, typename op_t>
+struct vecbinaryexpr : public vecexprbase<vecbinaryexpr<l_t, r_t, op_t>>
+{
+	using vecexpr_tag = void;
+	using value_type = std::common_type_t<typename l_t::value_type, typename r_t::value_type>;
+	static constexpr uint nd = std::max(l_t::nd, r_t::nd);
+	static_assert(l_t::nd == 0 || r_t::nd == 0 || l_t::nd == r_t::nd, "vec expression operands have different dimensions");
+
+	constexpr vecbinaryexpr(l_t const& _l, r_t const& _r) : l(_l), r(_r) {}
+	constexpr value_type operator[](uint i) const { return op_t()(l[i], r[i]); }
+
+	l_t l;
+	r_t r;
+};
+
+template<typename e_t, typename op_t>
+struct vecunaryexpr : public vecexprbase<vecunaryexpr<e_t, op_t>>
+{
+	using vecexpr_tag = void;
+	using value_type = typename e_t::value_type;
+	static constexpr uint nd = e_t::nd;
+
+	constexpr vecunaryexpr(e_t const& _e) : e(_e) {}
+	constexpr value_type operator[](uint i) const { return op_t()(e[i]); }
+
+	e_t e;
+};
+
+template<typename e_t>
+constexpr auto vecexprbase<e_t>::eval() const
+{
+	vec<e_t::nd, typename e_t::value_type> r;
+	for (uint i(0); i < e_t::nd; ++i) r[i] = self()[i];
+	return r;
+}
+
+// evaluates the expression and its squared length in the same pass
+template<typename e_t>
+constexpr auto vecexprbase<e_t>::normalized() const
+{
+	using t = typename e_t::value_type;
+	vec<e_t::nd, t> r;
+	t lensqr = t(0);
+	for (uint i(0); i < e_t::nd; ++i)
+	{
+		r[i] = self()[i];
+		lensqr += r[i] * r[i];
+	}
+
+	t const rcplen = t(1) / static_cast<t>(std::sqrt(lensqr) + 1.17e-38f);
+	for (uint i(0); i < e_t::nd; ++i) r[i] *= rcplen;
+	return r;
+}
+
+template<typename e_t>
+constexpr auto vecexprbase<e_t>::dot(auto const& r) const
+{
+	typename e_t::value_type res(0);
+	for (uint i(0); i < e_t::nd; ++i) res += self()[i] * r[i];
+	return res;
+}
+
+template<uint d, stdx::arithmeticpure_c t>
+constexpr auto lazy(vec<d, t> const& v) { return vecref<d, t>(v); }
+
+template<vecexpr_c e_t>
+constexpr auto lazy(e_t const& e) { return e; }
+
+// expression operands, vecs are referenced and scalars are broadcast
+template<vecexpr_c t>
+constexpr auto asoperand(t const& v) { return v; }
+
+template<uint d, stdx::arithmeticpure_c t>
+constexpr auto asoperand(vec<d, t> const& v) { return vecref<d, t>(v); }
+
+template<stdx::arithmeticpure_c t>
+constexpr auto asoperand(t v) { return vecscalar<t>{ v }; }
+
+template<typename t>
+using vecoperand_t = decltype(asoperand(std::declval<t const&>()));
+
+template<typename l_t, typename r_t>
+concept vecexproperands_c = (vecexpr_c<l_t> || vecexpr_c<r_t>) && requires(l_t l, r_t r) { asoperand(l); asoperand(r); };
+
+template<typename l_t, typename r_t, typename op_t>
+constexpr auto makevecexpr(l_t const& l, r_t const& r) { return vecbinaryexpr<vecoperand_t<l_t>, vecoperand_t<r_t>, op_t>(asoperand(l), asoperand(r)); }
+
+template<typename l_t, typename r_t> requires vecexproperands_c<l_t, r_t>
+constexpr auto operator+(l_t const& l, r_t const& r) { return makevecexpr<l_t, r_t, std::plus<>>(l, r); }
+
+template<typename l_t, typename r_t> requires vecexproperands_c<l_t, r_t>
+constexpr auto operator-(l_t const& l, r_t const& r) { return makevecexpr<l_t, r_t, std::minus<>>(l, r); }
+
+template<typename l_t, typename r_t> requires vecexproperands_c<l_t, r_t>
+constexpr auto operator*(l_t const& l, r_t const& r) { return makevecexpr<l_t, r_t, std::multiplies<>>(l, r); }
+
+template<typename l_t, typename r_t> requires vecexproperands_c<l_t, r_t>
+constexpr auto operator/(l_t const& l, r_t const& r) { return makevecexpr<l_t, r_t, std::divides<>>(l, r); }
+
+template<vecexpr_c e_t>
+constexpr auto operator-(e_t const& e) { return vecunaryexpr<e_t, std::negate<>>(e); }
+
 }
 
 export namespace std
@@ -0,0 +1,468 @@
+module;
+
+#include <immintrin.h>
+
+// gcc and clang define __FMA__ and __SSE4_1__ when they're enabled, msvc defines neither
+// msvc's /arch:AVX implies sse4.1 and every cpu /arch:AVX2 targets has fma
+#if defined(__FMA__) || (defined(_MSC_VER) && !defined(__clang__) && defined(__AVX2__))
+#define STDX_FMA 1
+#endif
+
+#if defined(__SSE4_1__) || (defined(_MSC_VER) && !defined(__clang__) && defined(__AVX__))
+#define STDX_SSE41 1
+#endif
+
+export module vec:simd;
+
+import stdxcore;
+import std;
+
+export namespace stdx::simd
+{
+
+// generic per component kernels, used for constant evaluation and for widths that don't map to a sse register
+template<uint d, stdx::arithmeticpure_c t>
+struct generickernels
+{
+	using array_t = std::array<t, d>;
+
+	static constexpr array_t neg(array_t const& v) { array_t r; for (uint i(0); i < d; ++i) r[i] = -v[i]; return r; }
+	static constexpr array_t add(array_t const& l, array_t const& r) { array_t res; for (uint i(0); i < d; ++i) res[i] = l[i] + r[i]; return res; }
+	static constexpr array_t sub(array_t const& l, array_t const& r) { array_t res; for (uint i(0); i < d; ++i) res[i] = l[i] - r[i]; return res; }
+	static constexpr array_t mul(array_t const& l, array_t const& r) { array_t res; for (uint i(0); i < d; ++i) res[i] = l[i] * r[i]; return res; }
+	static constexpr array_t div(array_t const& l, array_t const& r) { array_t res; for (uint i(0); i < d; ++i) res[i] = l[i] / r[i]; return res; }
+	static constexpr array_t add(array_t const& l, t r) { array_t res; for (uint i(0); i < d; ++i) res[i] = l[i] + r; return res; }
+	static constexpr array_t sub(array_t const& l, t r) { array_t res; for (uint i(0); i < d; ++i) res[i] = l[i] - r; return res; }
+	static constexpr array_t mul(array_t const& l, t r) { array_t res; for (uint i(0); i < d; ++i) res[i] = l[i] * r; return res; }
+	static constexpr array_t div(array_t const& l, t r) { array_t res; for (uint i(0); i < d; ++i) res[i] = l[i] / r; return res; }
+	static constexpr t dot(array_t const& l, array_t const& r) { t res = t(0); for (uint i(0); i < d; ++i) res += l[i] * r[i]; return res; }
+};
+
+// loads and stores never touch memory past the d components, so std::array layout of vec is preserved
+template<uint d>
+requires (d >= 2 && d <= 4)
+struct f32lanes
+{
+	using reg_t = __m128;
+
+	static reg_t load(float const* p)
+	{
+		if constexpr (d == 4) return _mm_loadu_ps(p);
+		reg_t const xy = _mm_castpd_ps(_mm_load_sd(reinterpret_cast<double const*>(p)));
+		if constexpr (d == 2) return xy;
+		else return _mm_movelh_ps(xy, _mm_load_ss(p + 2));
+	}
+
+	static void store(float* p, reg_t v)
+	{
+		if constexpr (d == 4) { _mm_storeu_ps(p, v); return; }
+		_mm_store_sd(reinterpret_cast<double*>(p), _mm_castps_pd(v));
+		if constexpr (d == 3) _mm_store_ss(p + 2, _mm_movehl_ps(v, v));
+	}
+
+	static reg_t set1(float v) { return _mm_set1_ps(v); }
+};
+
+template<uint d>
+requires (d >= 2 && d <= 4)
+struct i32lanes
+{
+	using reg_t = __m128i;
+
+	static reg_t load(void const* p)
+	{
+		if constexpr (d == 4) return _mm_loadu_si128(reinterpret_cast<reg_t const*>(p));
+		reg_t const xy = _mm_loadl_epi64(reinterpret_cast<reg_t const*>(p));
+		if constexpr (d == 2) return xy;
+		else return _mm_unpacklo_epi64(xy, _mm_cvtsi32_si128(reinterpret_cast<int const*>(p)[2]));
+	}
+
+	static void store(void* p, reg_t v)
+	{
+		if constexpr (d == 4) { _mm_storeu_si128(reinterpret_cast<reg_t*>(p), v); return; }
+		_mm_storel_epi64(reinterpret_cast<reg_t*>(p), v);
+		if constexpr (d == 3) reinterpret_cast<int*>(p)[2] = _mm_cvtsi128_si32(_mm_unpackhi_epi64(v, v));
+	}
+
+	static reg_t set1(auto v) { return _mm_set1_epi32(static_cast<int>(v)); }
+
+	// low 32 bits of each lane's product, sse2 only has 32x32->64 multiplies of the even lanes
+	static reg_t mullo(reg_t a, reg_t b)
+	{
+#if defined(STDX_SSE41)
+		return _mm_mullo_epi32(a, b);
+#else
+		reg_t const even = _mm_mul_epu32(a, b);
+		reg_t const odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+		return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+#endif
+	}
+};
+
+// applies a register op to one or two arrays that fit in a single sse register
+template<typename lanes_t, typename array_t>
+struct lanesop
+{
+	template<typename op_t>
+	static array_t apply(array_t const& v, op_t op)
+	{
+		array_t res;
+		lanes_t::store(res.data(), op(lanes_t::load(v.data())));
+		return res;
+	}
+
+	template<typename op_t>
+	static array_t apply(array_t const& l, array_t const& r, op_t op)
+	{
+		array_t res;
+		lanes_t::store(res.data(), op(lanes_t::load(l.data()), lanes_t::load(r.data())));
+		return res;
+	}
+
+	template<typename op_t>
+	static array_t apply(array_t const& l, typename lanes_t::reg_t r, op_t op)
+	{
+		array_t res;
+		lanes_t::store(res.data(), op(lanes_t::load(l.data()), r));
+		return res;
+	}
+};
+
+// kernels used by vec operators, specialized below for 2, 3 and 4 wide float, int and uint32
+template<uint d, stdx::arithmeticpure_c t>
+struct veckernels : public generickernels<d, t> {};
+
+template<uint d>
+requires (d >= 2 && d <= 4)
+struct veckernels<d, float>
+{
+	using generic = generickernels<d, float>;
+	using lanes = f32lanes<d>;
+	using array_t = std::array<float, d>;
+	using op = lanesop<lanes, array_t>;
+
+	static constexpr array_t neg(array_t const& v)
+	{
+		if (std::is_constant_evaluated()) return generic::neg(v);
+		return op::apply(v, [](__m128 a) { return _mm_xor_ps(a, _mm_set1_ps(-0.f)); });
+	}
+
+	static constexpr array_t add(array_t const& l, array_t const& r)
+	{
+		if (std::is_constant_evaluated()) return generic::add(l, r);
+		return op::apply(l, r, [](__m128 a, __m128 b) { return _mm_add_ps(a, b); });
+	}
+
+	static constexpr array_t sub(array_t const& l, array_t const& r)
+	{
+		if (std::is_constant_evaluated()) return generic::sub(l, r);
+		return op::apply(l, r, [](__m128 a, __m128 b) { return _mm_sub_ps(a, b); });
+	}
+
+	static constexpr array_t mul(array_t const& l, array_t const& r)
+	{
+		if (std::is_constant_evaluated()) return generic::mul(l, r);
+		return op::apply(l, r, [](__m128 a, __m128 b) { return _mm_mul_ps(a, b); });
+	}
+
+	static constexpr array_t div(array_t const& l, array_t const& r)
+	{
+		if (std::is_constant_evaluated()) return generic::div(l, r);
+		return op::apply(l, r, [](__m128 a, __m128 b) { return _mm_div_ps(a, b); });
+	}
+
+	static constexpr array_t add(array_t const& l, float r)
+	{
+		if (std::is_constant_evaluated()) return generic::add(l, r);
+		return op::apply(l, lanes::set1(r), [](__m128 a, __m128 b) { return _mm_add_ps(a, b); });
+	}
+
+	static constexpr array_t sub(array_t const& l, float r)
+	{
+		if (std::is_constant_evaluated()) return generic::sub(l, r);
+		return op::apply(l, lanes::set1(r), [](__m128 a, __m128 b) { return _mm_sub_ps(a, b); });
+	}
+
+	static constexpr array_t mul(array_t const& l, float r)
+	{
+		if (std::is_constant_evaluated()) return generic::mul(l, r);
+		return op::apply(l, lanes::set1(r), [](__m128 a, __m128 b) { return _mm_mul_ps(a, b); });
+	}
+
+	// divides every lane rather than multiplying by the reciprocal, so results match the constexpr path and scalar division
+	static constexpr array_t div(array_t const& l, float r)
+	{
+		if (std::is_constant_evaluated()) return generic::div(l, r);
+		return op::apply(l, lanes::set1(r), [](__m128 a, __m128 b) { return _mm_div_ps(a, b); });
+	}
+
+	// a dot product is a horizontal sum, which sse does no faster than scalar code on 2 to 4 lanes:
+	// on 1M vec3 dots _mm_dp_ps took 3.8 ms and mul with shuffled adds 1.9 ms against 1.3-1.6 ms for this loop
+	static constexpr float dot(array_t const& l, array_t const& r) { return generic::dot(l, r); }
+};
+
+// int and uint32 share the same lane ops(low 32 bits of a product don't depend on sign)
+// division has no sse equivalent and stays scalar
+template<uint d, stdx::arithmeticpure_c t>
+requires (d >= 2 && d <= 4 && sizeof(t) == 4 && std::is_integral_v<t>)
+struct veckernels<d, t>
+{
+	using generic = generickernels<d, t>;
+	using lanes = i32lanes<d>;
+	using array_t = std::array<t, d>;
+	using op = lanesop<lanes, array_t>;
+
+	static constexpr array_t neg(array_t const& v)
+	{
+		if (std::is_constant_evaluated()) return generic::neg(v);
+		return op::apply(v, [](__m128i a) { return _mm_sub_epi32(_mm_setzero_si128(), a); });
+	}
+
+	static constexpr array_t add(array_t const& l, array_t const& r)
+	{
+		if (std::is_constant_evaluated()) return generic::add(l, r);
+		return op::apply(l, r, [](__m128i a, __m128i b) { return _mm_add_epi32(a, b); });
+	}
+
+	static constexpr array_t sub(array_t const& l, array_t const& r)
+	{
+		if (std::is_constant_evaluated()) return generic::sub(l, r);
+		return op::apply(l, r, [](__m128i a, __m128i b) { return _mm_sub_epi32(a, b); });
+	}
+
+	static constexpr array_t mul(array_t const& l, array_t const& r)
+	{
+		if (std::is_constant_evaluated()) return generic::mul(l, r);
+		return op::apply(l, r, [](__m128i a, __m128i b) { return lanes::mullo(a, b); });
+	}
+
+	static constexpr array_t add(array_t const& l, t r)
+	{
+		if (std::is_constant_evaluated()) return generic::add(l, r);
+		return op::apply(l, lanes::set1(r), [](__m128i a, __m128i b) { return _mm_add_epi32(a, b); });
+	}
+
+	static constexpr array_t sub(array_t const& l, t r)
+	{
+		if (std::is_constant_evaluated()) return generic::sub(l, r);
+		return op::apply(l, lanes::set1(r), [](__m128i a, __m128i b) { return _mm_sub_epi32(a, b); });
+	}
+
+	static constexpr array_t mul(array_t const& l, t r)
+	{
+		if (std::is_constant_evaluated()) return generic::mul(l, r);
+		return op::apply(l, lanes::set1(r), [](__m128i a, __m128i b) { return lanes::mullo(a, b); });
+	}
+
+	static constexpr array_t div(array_t const& l, array_t const& r) { return generic::div(l, r); }
+	static constexpr array_t div(array_t const& l, t r) { return generic::div(l, r); }
+	static constexpr t dot(array_t const& l, array_t const& r) { return generic::dot(l, r); }
+};
+
+// row major 4x4 float matrix kernels, rows are contiguous and vectors transform as row vectors(v * m)
+struct mat4kernels
+{
+	static void load(float const* m, __m128 (&rows)[4])
+	{
+		for (uint i(0); i < 4; ++i) rows[i] = _mm_loadu_ps(m + i * 4);
+	}
+
+	static void store(float* m, __m128 const (&rows)[4])
+	{
+		for (uint i(0); i < 4; ++i) _mm_storeu_ps(m + i * 4, rows[i]);
+	}
+
+	// a * b + c, rounded once with fma
+	static __m128 madd(__m128 a, __m128 b, __m128 c)
+	{
+#if defined(STDX_FMA)
+		return _mm_fmadd_ps(a, b, c);
+#else
+		return _mm_add_ps(_mm_mul_ps(a, b), c);
+#endif
+	}
+
+	// v * m, as a linear combination of the rows of m
+	static __m128 transform(__m128 v, __m128 const (&m)[4])
+	{
+		__m128 r = _mm_mul_ps(_mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)), m[0]);
+		r = madd(_mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)), m[1], r);
+		r = madd(_mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2)), m[2], r);
+		return madd(_mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3)), m[3], r);
+	}
+
+	static void transform(float const* v, float const* m, float* r)
+	{
+		__m128 rows[4];
+		load(m, rows);
+		_mm_storeu_ps(r, transform(_mm_loadu_ps(v), rows));
+	}
+
+	static void mul(float const* a, float const* b, float* r)
+	{
+		__m128 brows[4], res[4];
+		load(b, brows);
+		for (uint i(0); i < 4; ++i) res[i] = transform(_mm_loadu_ps(a + i * 4), brows);
+		store(r, res);
+	}
+
+	static void transpose(float const* m, float* r)
+	{
+		__m128 rows[4];
+		load(m, rows);
+		_MM_TRANSPOSE4_PS(rows[0], rows[1], rows[2], rows[3]);
+		store(r, rows);
+	}
+
+	// 2x2 sub matrices are packed row major in one register as (x00, x01, x10, x11)
+	// a * b
+	static __m128 mul2x2(__m128 a, __m128 b)
+	{
+		return _mm_add_ps(_mm_mul_ps(a, _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 3, 0))), _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 2, 1, 2))));
+	}
+
+	// adj(a) * b
+	static __m128 adjmul2x2(__m128 a, __m128 b)
+	{
+		return _mm_sub_ps(_mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 0, 3, 3)), b), _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 1, 1)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 0, 3, 2))));
+	}
+
+	// a * adj(b)
+	static __m128 muladj2x2(__m128 a, __m128 b)
+	{
+		return _mm_sub_ps(_mm_mul_ps(a, _mm_shuffle_ps(b, b, _MM_SHUFFLE(0, 3, 0, 3))), _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 2, 1, 2))));
+	}
+
+	// general inverse using 2x2 blocks [a b; c d], returns the determinant
+	// the result isn't finite when the determinant is 0
+	static float inverse(float const* m, float* r)
+	{
+		__m128 rows[4];
+		load(m, rows);
+
+		__m128 const a = _mm_movelh_ps(rows[0], rows[1]);
+		__m128 const b = _mm_movehl_ps(rows[1], rows[0]);
+		__m128 const c = _mm_movelh_ps(rows[2], rows[3]);
+		__m128 const d = _mm_movehl_ps(rows[3], rows[2]);
+
+		// (|a|, |b|, |c|, |d|)
+		__m128 const dets = _mm_sub_ps(
+			_mm_mul_ps(_mm_shuffle_ps(rows[0], rows[2], _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(rows[1], rows[3], _MM_SHUFFLE(3, 1, 3, 1))),
+			_mm_mul_ps(_mm_shuffle_ps(rows[0], rows[2], _MM_SHUFFLE(3, 1, 3, 1)), _mm_shuffle_ps(rows[1], rows[3], _MM_SHUFFLE(2, 0, 2, 0))));
+
+		__m128 const deta = _mm_shuffle_ps(dets, dets, _MM_SHUFFLE(0, 0, 0, 0));
+		__m128 const detb = _mm_shuffle_ps(dets, dets, _MM_SHUFFLE(1, 1, 1, 1));
+		__m128 const detc = _mm_shuffle_ps(dets, dets, _MM_SHUFFLE(2, 2, 2, 2));
+		__m128 const detd = _mm_shuffle_ps(dets, dets, _MM_SHUFFLE(3, 3, 3, 3));
+
+		__m128 const dc = adjmul2x2(d, c);
+		__m128 const ab = adjmul2x2(a, b);
+
+		// adjugates of the blocks of the inverse, scaled by |m|
+		__m128 x = _mm_sub_ps(_mm_mul_ps(detd, a), mul2x2(b, dc));
+		__m128 w = _mm_sub_ps(_mm_mul_ps(deta, d), mul2x2(c, ab));
+		__m128 y = _mm_sub_ps(_mm_mul_ps(detb, c), muladj2x2(d, ab));
+		__m128 z = _mm_sub_ps(_mm_mul_ps(detc, b), muladj2x2(a, dc));
+
+		// |m| = |a||d| + |b||c| - tr(adj(a)b adj(d)c)
+		__m128 tr = _mm_mul_ps(ab, _mm_shuffle_ps(dc, dc, _MM_SHUFFLE(3, 1, 2, 0)));
+		tr = _mm_hadd_ps(tr, tr);
+		tr = _mm_hadd_ps(tr, tr);
+		__m128 const det = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(deta, detd), _mm_mul_ps(detb, detc)), tr);
+
+		__m128 const rdet = _mm_div_ps(_mm_setr_ps(1.f, -1.f, -1.f, 1.f), det);
+		x = _mm_mul_ps(x, rdet);
+		y = _mm_mul_ps(y, rdet);
+		z = _mm_mul_ps(z, rdet);
+		w = _mm_mul_ps(w, rdet);
+
+		// undo the adjugates while interleaving the blocks back to rows
+		__m128 const res[4] = {
+			_mm_shuffle_ps(x, y, _MM_SHUFFLE(1, 3, 1, 3)),
+			_mm_shuffle_ps(x, y, _MM_SHUFFLE(0, 2, 0, 2)),
+			_mm_shuffle_ps(z, w, _MM_SHUFFLE(1, 3, 1, 3)),
+			_mm_shuffle_ps(z, w, _MM_SHUFFLE(0, 2, 0, 2)) };
+
+		store(r, res);
+		return _mm_cvtss_f32(det);
+	}
+};
+
+// one register of packed floats for structure of arrays kernels, each lane holds a different element
+// 16 lanes when built with avx512, 8 with avx2
+struct f32pack
+{
+#if defined(__AVX512F__)
+	using reg_t = __m512;
+	using mask_t = __mmask16;
+	static constexpr uint width = 16;
+#else
+	using reg_t = __m256;
+	using mask_t = __m256;
+	static constexpr uint width = 8;
+#endif
+
+	reg_t v;
+
+#if defined(__AVX512F__)
+	static f32pack set1(float s) { return { _mm512_set1_ps(s) }; }
+	static f32pack load(float const* p) { return { _mm512_loadu_ps(p) }; }
+	void store(float* p) const { _mm512_storeu_ps(p, v); }
+
+	// lanes past count are zero and never read or written in memory
+	static f32pack loadpartial(float const* p, uint count) { return { _mm512_maskz_loadu_ps(lanemask(count), p) }; }
+	void storepartial(float* p, uint count) const { _mm512_mask_storeu_ps(p, lanemask(count), v); }
+
+	friend f32pack operator+(f32pack l, f32pack r) { return { _mm512_add_ps(l.v, r.v) }; }
+	friend f32pack operator-(f32pack l, f32pack r) { return { _mm512_sub_ps(l.v, r.v) }; }
+	friend f32pack operator*(f32pack l, f32pack r) { return { _mm512_mul_ps(l.v, r.v) }; }
+	friend f32pack operator/(f32pack l, f32pack r) { return { _mm512_div_ps(l.v, r.v) }; }
+
+	// a * b + c
+	static f32pack fmadd(f32pack a, f32pack b, f32pack c) { return { _mm512_fmadd_ps(a.v, b.v, c.v) }; }
+	static f32pack sqrt(f32pack a) { return { _mm512_sqrt_ps(a.v) }; }
+	static f32pack min(f32pack a, f32pack b) { return { _mm512_min_ps(a.v, b.v) }; }
+	static f32pack max(f32pack a, f32pack b) { return { _mm512_max_ps(a.v, b.v) }; }
+
+	// lanewise a < b, select takes iftrue where the mask is set
+	static mask_t less(f32pack a, f32pack b) { return _mm512_cmp_ps_mask(a.v, b.v, _CMP_LT_OQ); }
+	static f32pack select(mask_t m, f32pack iftrue, f32pack iffalse) { return { _mm512_mask_blend_ps(m, iffalse.v, iftrue.v) }; }
+	static bool any(mask_t m) { return m != 0; }
+
+private:
+	static __mmask16 lanemask(uint count) { return static_cast<__mmask16>((1u << count) - 1); }
+#else
+	static f32pack set1(float s) { return { _mm256_set1_ps(s) }; }
+	static f32pack load(float const* p) { return { _mm256_loadu_ps(p) }; }
+	void store(float* p) const { _mm256_storeu_ps(p, v); }
+
+	// lanes past count are zero and never read or written in memory
+	static f32pack loadpartial(float const* p, uint count) { return { _mm256_maskload_ps(p, lanemask(count)) }; }
+	void storepartial(float* p, uint count) const { _mm256_maskstore_ps(p, lanemask(count), v); }
+
+	friend f32pack operator+(f32pack l, f32pack r) { return { _mm256_add_ps(l.v, r.v) }; }
+	friend f32pack operator-(f32pack l, f32pack r) { return { _mm256_sub_ps(l.v, r.v) }; }
+	friend f32pack operator*(f32pack l, f32pack r) { return { _mm256_mul_ps(l.v, r.v) }; }
+	friend f32pack operator/(f32pack l, f32pack r) { return { _mm256_div_ps(l.v, r.v) }; }
+
+	// a * b + c
+#if defined(STDX_FMA)
+	static f32pack fmadd(f32pack a, f32pack b, f32pack c) { return { _mm256_fmadd_ps(a.v, b.v, c.v) }; }
+#else
+	static f32pack fmadd(f32pack a, f32pack b, f32pack c) { return { _mm256_add_ps(_mm256_mul_ps(a.v, b.v), c.v) }; }
+#endif
+	static f32pack sqrt(f32pack a) { return { _mm256_sqrt_ps(a.v) }; }
+	static f32pack min(f32pack a, f32pack b) { return { _mm256_min_ps(a.v, b.v) }; }
+	static f32pack max(f32pack a, f32pack b) { return { _mm256_max_ps(a.v, b.v) }; }
+
+	// lanewise a < b, select takes iftrue where the mask is set
+	static mask_t less(f32pack a, f32pack b) { return _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ); }
+	static f32pack select(mask_t m, f32pack iftrue, f32pack iffalse) { return { _mm256_blendv_ps(iffalse.v, iftrue.v, m) }; }
+	static bool any(mask_t m) { return _mm256_movemask_ps(m) != 0; }
+
+private:
+	static __m256i lanemask(uint count) { return _mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<int>(count)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)); }
+#endif
+};
+
+}